@@ -0,0 +1,2 @@
+setShader("assets/shader_scripts/shader.lua")
+addTexture("assets/terrain/forest/atlas")
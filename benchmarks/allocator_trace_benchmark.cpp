@@ -0,0 +1,184 @@
+// Replays an allocation trace against the first fit ListAllocator, TlsfAllocator and the thread caching front end.
+//
+// Pass a trace file to replay a recorded run. Every line is "a <id> <size> <alignment>" or "f <id>", ids name a live
+// allocation. Without a file a generated trace with the engine's mix is replayed: long lived containers that grow
+// by reallocating, short lived per frame scratch blocks and a steady churn of small nodes.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "engine/allocator.h"
+
+struct TraceEvent {
+    bool allocate;
+    uint32_t id;
+    uint32_t size;
+    uint32_t alignment;
+};
+
+static std::vector<TraceEvent> readTrace(const char *path) {
+    std::ifstream stream { path };
+    if (!stream) {
+        throw std::runtime_error(std::string("Failed to open trace ") + path);
+    }
+
+    std::vector<TraceEvent> trace;
+    char kind;
+    while (stream >> kind) {
+        TraceEvent event { kind == 'a', 0, 0, 0 };
+        stream >> event.id;
+        if (event.allocate) {
+            stream >> event.size >> event.alignment;
+        }
+
+        trace.push_back(event);
+    }
+
+    return trace;
+}
+
+static std::vector<TraceEvent> generateTrace(uint32_t frames) {
+    std::mt19937 random { 7 };
+    std::vector<TraceEvent> trace;
+    uint32_t nextId = 0;
+
+    auto allocate = [&](uint32_t size, uint32_t alignment) {
+        trace.push_back({ true, nextId, size, alignment });
+        return nextId++;
+    };
+
+    auto release = [&](uint32_t id) {
+        trace.push_back({ false, id, 0, 0 });
+    };
+
+    struct Container {
+        uint32_t id;
+        uint32_t capacity;
+    };
+
+    std::vector<Container> containers;
+    std::vector<uint32_t> nodes;
+
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        // Containers grow by half their capacity, a few are destroyed and recreated
+        if (containers.size() < 64 || random() % 4 == 0) {
+            containers.push_back({ allocate(64, 16), 64 });
+        }
+
+        for (int i = 0; i < 4; i++) {
+            auto &container = containers[random() % containers.size()];
+            if (container.capacity < 16 * 1024) {
+                auto grown = container.capacity + container.capacity / 2;
+                auto id = allocate(grown, 16);
+                release(container.id);
+                container = { id, grown };
+            }
+        }
+
+        if (containers.size() > 64 && random() % 8 == 0) {
+            auto index = random() % containers.size();
+            release(containers[index].id);
+            containers[index] = containers.back();
+            containers.pop_back();
+        }
+
+        // Scratch blocks that die within the frame
+        std::vector<uint32_t> scratch;
+        for (int i = 0; i < 16; i++) {
+            scratch.push_back(allocate(128 + random() % 4096, random() % 8 == 0 ? 64 : 16));
+        }
+
+        // Node churn, removed in random order
+        for (int i = 0; i < 48; i++) {
+            nodes.push_back(allocate(16 + random() % 112, 8));
+        }
+
+        std::shuffle(nodes.begin(), nodes.end(), random);
+        while (nodes.size() > 2048) {
+            release(nodes.back());
+            nodes.pop_back();
+        }
+
+        for (auto id : scratch) {
+            release(id);
+        }
+    }
+
+    for (auto &container : containers) {
+        release(container.id);
+    }
+
+    for (auto id : nodes) {
+        release(id);
+    }
+
+    return trace;
+}
+
+static double replay(Allocator &allocator, const std::vector<TraceEvent> &trace, uint32_t idCount) {
+    std::vector<void*> live(idCount, nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (const auto &event : trace) {
+        if (event.allocate) {
+            live[event.id] = allocator.allocate(event.size, event.alignment);
+        } else {
+            allocator.deallocate(live[event.id]);
+            live[event.id] = nullptr;
+        }
+    }
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    constexpr std::size_t PoolSize = 64 * 1024 * 1024;
+    constexpr int Rounds = 3;
+
+    auto trace = argc > 1 ? readTrace(argv[1]) : generateTrace(4000);
+
+    uint32_t idCount = 0;
+    for (const auto &event : trace) {
+        idCount = std::max(idCount, event.id + 1);
+    }
+
+    std::printf("%zu events\n", trace.size());
+
+    double list = 1e30;
+    double tlsf = 1e30;
+    double caching = 1e30;
+    std::size_t listPeak = 0;
+    std::size_t tlsfPeak = 0;
+
+    for (int round = 0; round < Rounds; round++) {
+        {
+            ListAllocator allocator { PoolSize };
+            list = std::min(list, replay(allocator, trace, idCount));
+            listPeak = allocator.peak();
+        }
+
+        {
+            TlsfAllocator allocator { PoolSize };
+            tlsf = std::min(tlsf, replay(allocator, trace, idCount));
+            tlsfPeak = allocator.peak();
+        }
+
+        {
+            TlsfAllocator backing { PoolSize };
+            ThreadCachingAllocator allocator { backing };
+            caching = std::min(caching, replay(allocator, trace, idCount));
+        }
+    }
+
+    std::printf("list      %8.1f ms   peak %zu KiB\n", list, listPeak / 1024);
+    std::printf("tlsf      %8.1f ms   peak %zu KiB\n", tlsf, tlsfPeak / 1024);
+    std::printf("caching   %8.1f ms\n", caching);
+
+    return 0;
+}
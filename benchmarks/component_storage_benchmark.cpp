@@ -0,0 +1,151 @@
+// Sparse set ComponentArray against the HashMap<Object, T> storage it replaced, in nanoseconds per entity
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "engine/allocator.h"
+#include "engine/map.h"
+#include "game/component_array.h"
+
+using game::Object;
+
+struct Component {
+    float position[3];
+    float velocity[3];
+    uint32_t flags;
+    uint32_t padding;
+};
+
+// The removed storage, get looked the key up with find before indexing it
+class HashMapStorage {
+public:
+    explicit HashMapStorage(Allocator &allocator)
+        : mComponents(allocator)
+    {
+    }
+
+    void insert(Object object, const Component &component) { mComponents.insert(object, component); }
+    void remove(Object object) { mComponents.remove(object); }
+
+    Component& get(Object object) {
+        if (mComponents.find(object) == mComponents.end()) {
+            throw std::runtime_error("Component does not exist");
+        }
+
+        return mComponents[object];
+    }
+
+    template<typename Callback>
+    void each(Callback &&callback) {
+        for (auto it = mComponents.begin(); it != mComponents.end(); ++it) {
+            callback(it.value());
+        }
+    }
+private:
+    HashMap<Object, Component> mComponents;
+};
+
+class SparseSetStorage {
+public:
+    explicit SparseSetStorage(Allocator &allocator)
+        : mComponents(allocator)
+    {
+    }
+
+    void insert(Object object, const Component &component) { mComponents.insert(object, component); }
+    void remove(Object object) { mComponents.remove(object); }
+    Component& get(Object object) { return mComponents.get(object); }
+
+    template<typename Callback>
+    void each(Callback &&callback) {
+        auto components = mComponents.components();
+        for (std::size_t i = 0; i < mComponents.size(); i++) {
+            callback(components[i]);
+        }
+    }
+private:
+    game::ComponentArray<Component> mComponents;
+};
+
+struct Timings {
+    double insert { 1e30 };
+    double get { 1e30 };
+    double iterate { 1e30 };
+    double remove { 1e30 };
+};
+
+template<typename Clock = std::chrono::steady_clock>
+static double nanosecondsPer(typename Clock::time_point start, std::size_t count) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(count);
+}
+
+// Best of several rounds, every round builds the storage from scratch
+template<typename Storage>
+static Timings measure(Allocator &allocator, const std::vector<Object> &objects, const std::vector<Object> &lookups) {
+    constexpr int Rounds = 5;
+    Timings best;
+    volatile float sink = 0.0f;
+
+    for (int round = 0; round < Rounds; round++) {
+        Storage storage { allocator };
+
+        auto start = std::chrono::steady_clock::now();
+        for (auto object : objects) {
+            storage.insert(object, Component { { float(object.id()), 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, 0, 0 });
+        }
+        best.insert = std::min(best.insert, nanosecondsPer(start, objects.size()));
+
+        float sum = 0.0f;
+        start = std::chrono::steady_clock::now();
+        for (auto object : lookups) {
+            sum += storage.get(object).position[0];
+        }
+        best.get = std::min(best.get, nanosecondsPer(start, lookups.size()));
+
+        start = std::chrono::steady_clock::now();
+        storage.each([&](Component &component) {
+            component.position[0] += component.velocity[0];
+            sum += component.position[0];
+        });
+        best.iterate = std::min(best.iterate, nanosecondsPer(start, objects.size()));
+
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < lookups.size(); i += 2) {
+            storage.remove(lookups[i]);
+        }
+        best.remove = std::min(best.remove, nanosecondsPer(start, lookups.size() / 2));
+
+        sink = sink + sum;
+    }
+
+    return best;
+}
+
+int main() {
+    TlsfAllocator allocator { 64 * 1024 * 1024 };
+    std::mt19937 random { 42 };
+
+    std::printf("%8s %-10s %8s %8s %8s %8s\n", "entities", "storage", "insert", "get", "iterate", "remove");
+
+    for (std::size_t count : { 1'000u, 10'000u, 100'000u }) {
+        std::vector<Object> objects;
+        for (uint32_t i = 0; i < count; i++) {
+            objects.emplace_back(i, 1, nullptr);
+        }
+
+        // Lookups and removals in random order, as systems touching other components would
+        auto lookups = objects;
+        std::shuffle(lookups.begin(), lookups.end(), random);
+
+        auto hashMap = measure<HashMapStorage>(allocator, objects, lookups);
+        auto sparseSet = measure<SparseSetStorage>(allocator, objects, lookups);
+
+        std::printf("%8zu %-10s %8.1f %8.1f %8.1f %8.1f\n", count, "hashmap", hashMap.insert, hashMap.get, hashMap.iterate, hashMap.remove);
+        std::printf("%8zu %-10s %8.1f %8.1f %8.1f %8.1f\n", count, "sparseset", sparseSet.insert, sparseSet.get, sparseSet.iterate, sparseSet.remove);
+    }
+
+    return 0;
+}
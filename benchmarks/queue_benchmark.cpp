@@ -0,0 +1,101 @@
+// Throughput of the engine queues against a mutex protected std::deque, in million items per second
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "engine/allocator.h"
+#include "engine/queue.h"
+
+class MutexQueue {
+public:
+    bool push(uint64_t value) {
+        std::lock_guard lock(mMutex);
+        mItems.push_back(value);
+        return true;
+    }
+
+    std::optional<uint64_t> pop() {
+        std::lock_guard lock(mMutex);
+        if (mItems.empty()) {
+            return std::nullopt;
+        }
+
+        auto value = mItems.front();
+        mItems.pop_front();
+        return value;
+    }
+private:
+    std::mutex mMutex;
+    std::deque<uint64_t> mItems;
+};
+
+template<typename Queue>
+static double measure(Queue &queue, int producerCount, int consumerCount, uint64_t perProducer) {
+    auto total = perProducer * producerCount;
+    std::atomic<uint64_t> popped { 0 };
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int p = 0; p < producerCount; p++) {
+        threads.emplace_back([&]() {
+            for (uint64_t i = 0; i < perProducer; i++) {
+                while (!queue.push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (int c = 0; c < consumerCount; c++) {
+        threads.emplace_back([&]() {
+            while (popped.load(std::memory_order_relaxed) < total) {
+                if (queue.pop()) {
+                    popped.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(total) / elapsed.count() / 1e6;
+}
+
+int main() {
+    constexpr uint64_t Items = 4'000'000;
+    constexpr std::size_t Capacity = 4096;
+
+    TlsfAllocator allocator { 1024 * 1024 };
+
+    {
+        SpscQueue<uint64_t> spsc { allocator, Capacity };
+        MutexQueue locked;
+        std::printf("1p/1c   spsc %7.1f   mpmc ", measure(spsc, 1, 1, Items));
+
+        MpmcQueue<uint64_t> mpmc { allocator, Capacity };
+        std::printf("%7.1f   mutex %7.1f\n", measure(mpmc, 1, 1, Items), measure(locked, 1, 1, Items));
+    }
+
+    for (auto [producers, consumers] : { std::pair { 2, 2 }, std::pair { 4, 4 }, std::pair { 4, 1 }, std::pair { 1, 4 } }) {
+        MpmcQueue<uint64_t> mpmc { allocator, Capacity };
+        MutexQueue locked;
+
+        auto perProducer = Items / producers;
+        std::printf("%dp/%dc   mpmc %7.1f   mutex %7.1f\n", producers, consumers,
+                    measure(mpmc, producers, consumers, perProducer), measure(locked, producers, consumers, perProducer));
+    }
+
+    return 0;
+}
@@ -4,39 +4,65 @@ out vec4 FragColor;
 in vec2 TexCoord;
 in vec3 Normal;
 in vec3 FragPos;
+in float ViewDepth;
 
 uniform sampler2D texture1;
 
+// Four texels per light, filled by gfx::LightClusters
+uniform samplerBuffer pointLightData;
+// Offset and count into clusterLights for every cluster
+uniform usamplerBuffer clusterRanges;
+uniform usamplerBuffer clusterLights;
+
 struct PointLight {
-    vec3 position; // 16
+    vec3 position;
+    float range;
 
-    vec3 ambient; // 16
-    vec3 diffuse; // 16
-    vec3 specular; // 16
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
 
-    float constant; // 16
-    float linear; // 16
-    float quadratic; // 16
-}; // 112
+    float constant;
+    float linear;
+    float quadratic;
+};
 
+// Mirrored by gfx::DirLight, its std140 offsets are checked there
 struct DirLight {
-    vec3 direction; // 16
+    vec3 direction; // 0
 
     vec3 ambient; // 16
-    vec3 diffuse; // 16
-    vec3 specular; // 16
+    vec3 diffuse; // 32
+    vec3 specular; // 48
 }; // 64 total
 
 #define MAX_DIR_LIGHTS 4
-#define MAX_POINT_LIGHTS 8
 
 layout (std140) uniform Lights {
     int dirLightsCount;
     DirLight dirLights[MAX_DIR_LIGHTS];
-    int pointLightsCount;
-    PointLight pointLights[MAX_POINT_LIGHTS];
+    uvec4 clusterSize;
+    // Tile size in pixels, then scale and bias from log(depth) to depth slice
+    vec4 clusterParams;
 };
 
+PointLight FetchPointLight(int index) {
+    vec4 t0 = texelFetch(pointLightData, index * 4);
+    vec4 t1 = texelFetch(pointLightData, index * 4 + 1);
+    vec4 t2 = texelFetch(pointLightData, index * 4 + 2);
+    vec4 t3 = texelFetch(pointLightData, index * 4 + 3);
+
+    return PointLight(t0.xyz, t0.w, t1.xyz, t2.xyz, t3.xyz, t1.w, t2.w, t3.w);
+}
+
+int ClusterIndex() {
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterParams.xy), clusterSize.xy - 1u);
+    float slice = log(max(ViewDepth, 1e-4)) * clusterParams.z + clusterParams.w;
+    uint z = uint(clamp(slice, 0.0, float(clusterSize.z - 1u)));
+
+    return int(tile.x + clusterSize.x * (tile.y + clusterSize.y * z));
+}
+
 vec3 CalculatePointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 pixel) {
     // ambient
     vec3 ambient = light.ambient * pixel;
@@ -82,8 +108,11 @@ void main()
     for (int i = 0; i < dirLightsCount; i++) {
         result += CalulateDirLight(dirLights[i], normal, viewDir, vec3(texColor));
     }
-    for (int i = 0; i < pointLightsCount; i++) {
-        result += CalculatePointLight(pointLights[i], normal, viewDir, vec3(texColor));
+
+    uvec2 range = texelFetch(clusterRanges, ClusterIndex()).xy;
+    for (uint i = 0u; i < range.y; i++) {
+        int lightIndex = int(texelFetch(clusterLights, int(range.x + i)).x);
+        result += CalculatePointLight(FetchPointLight(lightIndex), normal, viewDir, vec3(texColor));
     }
 
     FragColor = vec4(result, 1.0);
@@ -2,21 +2,27 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+// Per instance, takes locations 3 to 6
+layout (location = 3) in mat4 aModel;
 
 out vec2 TexCoord;
 out vec3 Normal;
 out vec3 FragPos;
+out float ViewDepth;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform mat4 invtransmodel;
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(invtransmodel) * aNormal;
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+    Normal = transpose(inverse(mat3(aModel))) * aNormal;
     TexCoord = aTexCoord;
 
-    gl_Position = projection * view * model * vec4(aPos, 1.0f);
+    vec4 viewPos = view * aModel * vec4(aPos, 1.0f);
+    ViewDepth = -viewPos.z;
+
+    gl_Position = projection * viewPos;
 }
\ No newline at end of file
@@ -1,5 +1,10 @@
 #include "allocator.h"
 
+#include <atomic>
+#include <bit>
+#include <cstdlib>
+#include <stdexcept>
+
 inline constexpr std::size_t calculatePadding(std::size_t size, std::size_t alignment) {
     auto remainder = size % alignment;
     if (remainder > 0) {
@@ -43,13 +48,20 @@ ListAllocator::~ListAllocator()
 }
 
 void *ListAllocator::allocate(std::size_t size, std::size_t alignment) {
-    auto padding = calculatePadding(mUsed, alignment, sizeof(AllocatedBlock));
-    auto requiredSize = size + padding + sizeof(AllocatedBlock);
-
     auto* current = mFreeBlocks.head;
     Node* previous = nullptr;
 
+    std::size_t padding = 0;
+    std::size_t requiredSize = 0;
+
     while (current != nullptr) {
+        // The header sits right in front of the aligned data, the padding includes the header
+        padding = calculatePadding((std::size_t) current, alignment, sizeof(AllocatedBlock));
+        requiredSize = size + padding;
+
+        // Keep every block aligned to fit a free node header
+        requiredSize += calculatePadding(requiredSize, alignof(Node));
+
         if (current->data.size >= requiredSize) {
             // Found a block that fits
             break;
@@ -60,15 +72,14 @@ void *ListAllocator::allocate(std::size_t size, std::size_t alignment) {
         current = current->next;
     }
 
-    if (current->data.size < requiredSize) {
+    if (current == nullptr) {
         // No block with enough memory found
         throw std::bad_alloc();
     }
 
     // Calculate the new free block size
     auto newFreeBlockSize = current->data.size - requiredSize;
-    if (newFreeBlockSize > 0) {
-        // TODO - what if the new free block is smaller than the header size?
+    if (newFreeBlockSize >= sizeof(Node)) {
         // There is space left for a new free block
         auto currentAddress = (std::size_t) current;
         auto newFreeBlock = (Node*)(currentAddress + requiredSize);
@@ -78,19 +89,21 @@ void *ListAllocator::allocate(std::size_t size, std::size_t alignment) {
 
         // Insert the new free block
         mFreeBlocks.insert(newFreeBlock, current);
+    } else {
+        // The remainder can't hold a free block, hand it out with this allocation
+        requiredSize = current->data.size;
     }
 
     // Remove the node from the free-headers list
     mFreeBlocks.remove(current, previous);
 
     // Calculate the address of the new allocated block
-    auto headerAddress = (std::size_t)(current);
+    auto dataAddress = (std::size_t)(current) + padding;
+    auto headerAddress = dataAddress - sizeof(AllocatedBlock);
 
-    ((AllocatedBlock*) headerAddress)->size = size;
+    ((AllocatedBlock*) headerAddress)->size = requiredSize;
     ((AllocatedBlock*) headerAddress)->padding = padding;
 
-    auto dataAddress = headerAddress + sizeof(AllocatedBlock);
-
     mUsed += requiredSize;
     mPeak = std::max(mPeak, mUsed);
 
@@ -103,30 +116,27 @@ void ListAllocator::deallocate(void *pointer) {
     }
 
     auto currentAddress = (std::size_t)(pointer);
-    auto headerAddress = currentAddress - sizeof(AllocatedBlock);
-    auto allocatedHeader = (AllocatedBlock*)(headerAddress);
+    auto allocatedHeader = (AllocatedBlock*)(currentAddress - sizeof(AllocatedBlock));
 
-    auto blockSize = allocatedHeader->size + allocatedHeader->padding + sizeof(AllocatedBlock);
+    auto blockSize = allocatedHeader->size;
+    auto blockAddress = currentAddress - allocatedHeader->padding;
 
-    auto newFreeBlock = (Node*)(headerAddress);
+    auto newFreeBlock = (Node*)(blockAddress);
     newFreeBlock->data.size = blockSize;
     newFreeBlock->next = nullptr;
 
     auto* current = mFreeBlocks.head;
     Node* previous = nullptr;
 
-    while (current != nullptr) {
-        if ((std::size_t)(current) >= headerAddress) {
-            // Found the block that is after the new free block
-            mFreeBlocks.insert(newFreeBlock, previous);
-            break;
-        }
-
+    while (current != nullptr && (std::size_t)(current) < blockAddress) {
         // Move to next block
         previous = current;
         current = current->next;
     }
 
+    // Insert in front of the first block after the freed block, keeping the list sorted by address
+    mFreeBlocks.insert(newFreeBlock, previous);
+
     mUsed -= blockSize;
 
     tryMergeFreedBlock(newFreeBlock, previous);
@@ -142,6 +152,18 @@ void ListAllocator::reset() {
     mFreeBlocks.insert(firstNode, nullptr);
 }
 
+FragmentationStats ListAllocator::fragmentation() const {
+    FragmentationStats stats;
+
+    for (auto node = mFreeBlocks.head; node != nullptr; node = node->next) {
+        stats.freeBytes += node->data.size;
+        stats.largestFreeBlock = std::max(stats.largestFreeBlock, node->data.size);
+        stats.freeBlockCount++;
+    }
+
+    return stats;
+}
+
 void ListAllocator::tryMergeFreedBlock(ListAllocator::Node *freeNode, ListAllocator::Node *previousNode) {
     auto nextNode = freeNode->next;
 
@@ -167,3 +189,531 @@ void ListAllocator::tryMergeFreedBlock(ListAllocator::Node *freeNode, ListAlloca
         }
     }
 }
+
+TlsfAllocator::TlsfAllocator(std::size_t size)
+    : Allocator(size)
+{
+    if (size < 2 * BlockHeaderSize + MinBlockSize || size >= (std::size_t { 1 } << FlIndexMax)) {
+        throw std::runtime_error("Invalid TLSF pool size");
+    }
+
+    mStart = std::aligned_alloc(BlockAlignment, size - size % BlockAlignment);
+    reset();
+}
+
+TlsfAllocator::~TlsfAllocator() {
+    std::free(mStart);
+}
+
+void TlsfAllocator::reset() {
+    mUsed = 0;
+    mPeak = 0;
+
+    mFlBitmap = 0;
+    mSlBitmaps.fill(0);
+    for (auto &list : mFreeBlocks) {
+        list.fill(nullptr);
+    }
+
+    // One free block spanning the pool, followed by a used zero sized sentinel that stops merging at the end
+    auto poolSize = mTotalSize - mTotalSize % BlockAlignment;
+
+    auto block = static_cast<BlockHeader*>(mStart);
+    block->size = (poolSize - 2 * BlockHeaderSize) | FreeBit;
+    block->previousPhysical = nullptr;
+
+    auto sentinel = nextPhysical(block);
+    sentinel->size = 0;
+    sentinel->previousPhysical = block;
+
+    insertFreeBlock(block);
+}
+
+FragmentationStats TlsfAllocator::fragmentation() const {
+    FragmentationStats stats;
+
+    for (const auto &lists : mFreeBlocks) {
+        for (auto block : lists) {
+            for (; block != nullptr; block = block->nextFree) {
+                auto size = blockSize(block);
+
+                stats.freeBytes += size;
+                stats.largestFreeBlock = std::max(stats.largestFreeBlock, size);
+                stats.freeBlockCount++;
+            }
+        }
+    }
+
+    return stats;
+}
+
+void TlsfAllocator::mapping(std::size_t size, uint32_t &fl, uint32_t &sl) {
+    if (size < SmallBlockSize) {
+        fl = 0;
+        sl = static_cast<uint32_t>(size / (SmallBlockSize / SlIndexCount));
+        return;
+    }
+
+    auto msb = static_cast<uint32_t>(std::bit_width(size) - 1);
+    sl = static_cast<uint32_t>((size >> (msb - SlIndexCountLog2)) ^ SlIndexCount);
+    fl = msb - (FlIndexShift - 1);
+}
+
+void TlsfAllocator::mappingSearch(std::size_t size, uint32_t &fl, uint32_t &sl) {
+    // Round up to the next class so every block in the found list is large enough
+    if (size >= SmallBlockSize) {
+        auto msb = std::bit_width(size) - 1;
+        size += (std::size_t { 1 } << (msb - SlIndexCountLog2)) - 1;
+    }
+
+    mapping(size, fl, sl);
+}
+
+TlsfAllocator::BlockHeader* TlsfAllocator::findFreeBlock(std::size_t size) {
+    uint32_t fl, sl;
+    mappingSearch(size, fl, sl);
+
+    if (fl >= FlIndexCount) {
+        return nullptr;
+    }
+
+    auto slMap = mSlBitmaps[fl] & (~0u << sl);
+    if (slMap == 0) {
+        auto flMap = fl + 1 < 32 ? mFlBitmap & (~0u << (fl + 1)) : 0;
+        if (flMap == 0) {
+            return nullptr;
+        }
+
+        fl = std::countr_zero(flMap);
+        slMap = mSlBitmaps[fl];
+    }
+
+    sl = std::countr_zero(slMap);
+
+    return mFreeBlocks[fl][sl];
+}
+
+void TlsfAllocator::insertFreeBlock(BlockHeader *block) {
+    uint32_t fl, sl;
+    mapping(blockSize(block), fl, sl);
+
+    auto head = mFreeBlocks[fl][sl];
+    block->nextFree = head;
+    block->previousFree = nullptr;
+
+    if (head) {
+        head->previousFree = block;
+    }
+
+    mFreeBlocks[fl][sl] = block;
+    mFlBitmap |= 1u << fl;
+    mSlBitmaps[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::removeFreeBlock(BlockHeader *block) {
+    uint32_t fl, sl;
+    mapping(blockSize(block), fl, sl);
+
+    if (block->previousFree) {
+        block->previousFree->nextFree = block->nextFree;
+    } else {
+        mFreeBlocks[fl][sl] = block->nextFree;
+    }
+
+    if (block->nextFree) {
+        block->nextFree->previousFree = block->previousFree;
+    }
+
+    if (mFreeBlocks[fl][sl] == nullptr) {
+        mSlBitmaps[fl] &= ~(1u << sl);
+        if (mSlBitmaps[fl] == 0) {
+            mFlBitmap &= ~(1u << fl);
+        }
+    }
+}
+
+void TlsfAllocator::trimBlock(BlockHeader *block, std::size_t size) {
+    auto currentSize = blockSize(block);
+    if (currentSize < size + BlockHeaderSize + MinBlockSize) {
+        return;
+    }
+
+    auto next = nextPhysical(block);
+
+    auto remainder = reinterpret_cast<BlockHeader*>(payload(block) + size);
+    remainder->size = (currentSize - size - BlockHeaderSize) | FreeBit;
+    remainder->previousPhysical = block;
+
+    block->size = size | (block->size & FreeBit);
+    next->previousPhysical = remainder;
+
+    insertFreeBlock(mergeWithNeighbours(remainder));
+}
+
+TlsfAllocator::BlockHeader* TlsfAllocator::mergeWithNeighbours(BlockHeader *block) {
+    auto next = nextPhysical(block);
+    if (isFree(next)) {
+        removeFreeBlock(next);
+        block->size += BlockHeaderSize + blockSize(next);
+        nextPhysical(block)->previousPhysical = block;
+    }
+
+    auto previous = block->previousPhysical;
+    if (previous && isFree(previous)) {
+        removeFreeBlock(previous);
+        previous->size += BlockHeaderSize + blockSize(block);
+        nextPhysical(previous)->previousPhysical = previous;
+        block = previous;
+    }
+
+    return block;
+}
+
+void *TlsfAllocator::allocate(std::size_t size, std::size_t alignment) {
+    size = std::max(size + calculatePadding(size, BlockAlignment), MinBlockSize);
+
+    // Over aligned requests reserve room to split off a leading free block up to the aligned address
+    auto overAligned = alignment > BlockAlignment;
+    auto searchSize = overAligned ? size + alignment + BlockHeaderSize + MinBlockSize : size;
+
+    auto block = findFreeBlock(searchSize);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    removeFreeBlock(block);
+
+    if (overAligned) {
+        auto address = reinterpret_cast<std::size_t>(payload(block));
+        auto gap = calculatePadding(address, alignment);
+
+        if (gap > 0 && gap < BlockHeaderSize + MinBlockSize) {
+            // The leading part has to be able to hold a free block of its own
+            gap = calculatePadding(address + BlockHeaderSize + MinBlockSize, alignment) + BlockHeaderSize + MinBlockSize;
+        }
+
+        if (gap > 0) {
+            auto next = nextPhysical(block);
+            auto aligned = reinterpret_cast<BlockHeader*>(payload(block) + gap - BlockHeaderSize);
+
+            aligned->size = blockSize(block) - gap;
+            aligned->previousPhysical = block;
+            next->previousPhysical = aligned;
+
+            block->size = (gap - BlockHeaderSize) | FreeBit;
+            insertFreeBlock(block);
+
+            block = aligned;
+        }
+    }
+
+    block->size &= ~FreeBit;
+    trimBlock(block, size);
+
+    mUsed += blockSize(block) + BlockHeaderSize;
+    mPeak = std::max(mPeak, mUsed);
+
+    return payload(block);
+}
+
+void TlsfAllocator::deallocate(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+
+    auto block = reinterpret_cast<BlockHeader*>(static_cast<std::byte*>(pointer) - BlockHeaderSize);
+    mUsed -= blockSize(block) + BlockHeaderSize;
+
+    block->size |= FreeBit;
+    insertFreeBlock(mergeWithNeighbours(block));
+}
+
+FrameArena::FrameArena(std::size_t size)
+    : Allocator(size)
+    , mFrameSize(size / 2)
+{
+    mStart = std::malloc(size);
+    mCurrent = static_cast<std::byte*>(mStart);
+}
+
+FrameArena::~FrameArena() {
+    std::free(mStart);
+}
+
+void *FrameArena::allocate(std::size_t size, std::size_t alignment) {
+    auto address = reinterpret_cast<std::size_t>(mCurrent) + mUsed;
+    auto padding = calculatePadding(address, alignment);
+
+    if (mUsed + padding + size > mFrameSize) {
+        throw std::bad_alloc();
+    }
+
+    mUsed += padding + size;
+
+    return reinterpret_cast<void*>(address + padding);
+}
+
+void FrameArena::swap() {
+    mLastFramePeak = mUsed;
+    mPeak = std::max(mPeak, mUsed);
+
+    mFrameIndex ^= 1;
+    mCurrent = static_cast<std::byte*>(mStart) + mFrameIndex * mFrameSize;
+    mUsed = 0;
+}
+
+thread_local ThreadCachingAllocator::ThreadCache ThreadCachingAllocator::sThreadCache;
+
+ThreadCachingAllocator::ThreadCache::~ThreadCache() {
+    if (owner == nullptr) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < SizeClassCount; i++) {
+        owner->flush(magazines[i], i, magazines[i].count);
+    }
+}
+
+ThreadCachingAllocator::ThreadCachingAllocator(Allocator &backing)
+    : Allocator(0)
+    , mBacking(backing)
+{
+}
+
+ThreadCachingAllocator::~ThreadCachingAllocator() {
+    // Blocks cached by the current thread point into the slabs released below
+    if (sThreadCache.owner == this) {
+        sThreadCache.owner = nullptr;
+        for (auto &magazine : sThreadCache.magazines) {
+            magazine.count = 0;
+        }
+    }
+
+    for (auto slab : mSlabs) {
+        mBacking.deallocate(slab);
+    }
+}
+
+uint32_t ThreadCachingAllocator::sizeClass(std::size_t size) {
+    if (size <= 128) {
+        return size == 0 ? 0 : static_cast<uint32_t>((size + 15) / 16 - 1);
+    }
+
+    for (uint32_t i = 8; i < SizeClassCount; i++) {
+        if (size <= SizeClasses[i]) {
+            return i;
+        }
+    }
+
+    return LargeClass;
+}
+
+ThreadCachingAllocator::ThreadCache* ThreadCachingAllocator::threadCache() {
+    auto &cache = sThreadCache;
+    if (cache.owner == nullptr) {
+        cache.owner = this;
+    }
+
+    return cache.owner == this ? &cache : nullptr;
+}
+
+void *ThreadCachingAllocator::allocate(std::size_t size, std::size_t alignment) {
+    auto sizeClass = alignment <= HeaderSize ? this->sizeClass(size) : LargeClass;
+    if (sizeClass == LargeClass) {
+        return allocateLarge(size, alignment);
+    }
+
+    addUsed(SizeClasses[sizeClass]);
+
+    auto cache = threadCache();
+    if (cache == nullptr) {
+        // Bound to another allocator, move single blocks through the central heap
+        Magazine magazine;
+        refill(magazine, sizeClass);
+
+        auto block = magazine.blocks[--magazine.count];
+        flush(magazine, sizeClass, magazine.count);
+
+        return block;
+    }
+
+    auto &magazine = cache->magazines[sizeClass];
+    if (magazine.count == 0) {
+        refill(magazine, sizeClass);
+    }
+
+    return magazine.blocks[--magazine.count];
+}
+
+void ThreadCachingAllocator::deallocate(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+
+    auto blockHeader = header(pointer);
+    auto sizeClass = blockHeader->sizeClass;
+
+    if (sizeClass == LargeClass) {
+        subtractUsed(blockHeader->size);
+
+        std::lock_guard lock(mMutex);
+        mFootprint -= blockHeader->size + blockHeader->offset;
+        mBacking.deallocate(static_cast<std::byte*>(pointer) - blockHeader->offset);
+        return;
+    }
+
+    subtractUsed(SizeClasses[sizeClass]);
+
+    auto cache = threadCache();
+    if (cache == nullptr) {
+        Magazine magazine;
+        magazine.blocks[magazine.count++] = pointer;
+        flush(magazine, sizeClass, 1);
+        return;
+    }
+
+    auto &magazine = cache->magazines[sizeClass];
+    if (magazine.count == MagazineCapacity) {
+        flush(magazine, sizeClass, TransferCount);
+    }
+
+    magazine.blocks[magazine.count++] = pointer;
+}
+
+void ThreadCachingAllocator::refill(Magazine &magazine, uint32_t sizeClass) {
+    std::lock_guard lock(mMutex);
+
+    if (mCentralFreeLists[sizeClass] == nullptr) {
+        carveSlab(sizeClass);
+    }
+
+    while (mCentralFreeLists[sizeClass] != nullptr && magazine.count < TransferCount) {
+        auto block = mCentralFreeLists[sizeClass];
+        unlinkFree(sizeClass, block);
+        slab(block)->freeCount--;
+
+        magazine.blocks[magazine.count++] = block;
+    }
+}
+
+void ThreadCachingAllocator::flush(Magazine &magazine, uint32_t sizeClass, uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    std::lock_guard lock(mMutex);
+
+    for (uint32_t i = 0; i < count; i++) {
+        auto block = static_cast<FreeBlock*>(magazine.blocks[--magazine.count]);
+        pushFree(sizeClass, block);
+
+        // Hand slabs back once every block is home, keeping a batch around so a refill doesn't carve right away
+        auto blockSlab = slab(block);
+        if (++blockSlab->freeCount == TransferCount && mCentralFreeCounts[sizeClass] > ReleaseThreshold) {
+            releaseSlab(blockSlab);
+        }
+    }
+}
+
+void ThreadCachingAllocator::carveSlab(uint32_t sizeClass) {
+    auto blockSize = HeaderSize + SizeClasses[sizeClass];
+    auto slabSize = HeaderSize + blockSize * TransferCount;
+
+    auto slab = static_cast<SlabHeader*>(mBacking.allocate(slabSize, HeaderSize));
+    slab->sizeClass = sizeClass;
+    slab->freeCount = TransferCount;
+    slab->index = static_cast<uint32_t>(mSlabs.size());
+    mSlabs.push_back(slab);
+    mFootprint += slabSize;
+
+    auto blocks = reinterpret_cast<std::byte*>(slab) + HeaderSize;
+    for (uint32_t i = TransferCount; i > 0; i--) {
+        auto block = blocks + (i - 1) * blockSize;
+        auto payload = block + HeaderSize;
+
+        auto blockHeader = reinterpret_cast<BlockHeader*>(block);
+        blockHeader->sizeClass = sizeClass;
+        blockHeader->offset = static_cast<uint32_t>(payload - reinterpret_cast<std::byte*>(slab));
+
+        pushFree(sizeClass, reinterpret_cast<FreeBlock*>(payload));
+    }
+}
+
+void ThreadCachingAllocator::releaseSlab(SlabHeader *slab) {
+    auto sizeClass = slab->sizeClass;
+    auto blockSize = HeaderSize + SizeClasses[sizeClass];
+
+    auto blocks = reinterpret_cast<std::byte*>(slab) + HeaderSize;
+    for (uint32_t i = 0; i < TransferCount; i++) {
+        unlinkFree(sizeClass, reinterpret_cast<FreeBlock*>(blocks + i * blockSize + HeaderSize));
+    }
+
+    mSlabs[slab->index] = mSlabs.back();
+    mSlabs[slab->index]->index = slab->index;
+    mSlabs.pop_back();
+
+    mFootprint -= HeaderSize + blockSize * TransferCount;
+    mBacking.deallocate(slab);
+}
+
+void ThreadCachingAllocator::pushFree(uint32_t sizeClass, FreeBlock *block) {
+    auto &head = mCentralFreeLists[sizeClass];
+
+    block->prev = nullptr;
+    block->next = head;
+    if (head != nullptr) {
+        head->prev = block;
+    }
+
+    head = block;
+    mCentralFreeCounts[sizeClass]++;
+}
+
+void ThreadCachingAllocator::unlinkFree(uint32_t sizeClass, FreeBlock *block) {
+    if (block->prev != nullptr) {
+        block->prev->next = block->next;
+    } else {
+        mCentralFreeLists[sizeClass] = block->next;
+    }
+
+    if (block->next != nullptr) {
+        block->next->prev = block->prev;
+    }
+
+    mCentralFreeCounts[sizeClass]--;
+}
+
+// Blocks come and go on every thread without the central lock, so the counters are updated atomically
+void ThreadCachingAllocator::addUsed(std::size_t size) {
+    auto used = std::atomic_ref(mUsed).fetch_add(size, std::memory_order_relaxed) + size;
+
+    std::atomic_ref peak(mPeak);
+    auto current = peak.load(std::memory_order_relaxed);
+    while (used > current && !peak.compare_exchange_weak(current, used, std::memory_order_relaxed)) {
+    }
+}
+
+void ThreadCachingAllocator::subtractUsed(std::size_t size) {
+    std::atomic_ref(mUsed).fetch_sub(size, std::memory_order_relaxed);
+}
+
+void *ThreadCachingAllocator::allocateLarge(std::size_t size, std::size_t alignment) {
+    // The header sits right in front of the payload, keep the payload aligned behind it
+    auto offset = std::max(HeaderSize, alignment);
+
+    std::unique_lock lock(mMutex);
+
+    auto block = static_cast<std::byte*>(mBacking.allocate(size + offset, std::max(alignment, HeaderSize)));
+    auto payload = block + offset;
+    mFootprint += size + offset;
+
+    lock.unlock();
+
+    header(payload)->sizeClass = LargeClass;
+    header(payload)->offset = static_cast<uint32_t>(offset);
+    header(payload)->size = size;
+
+    addUsed(size);
+
+    return payload;
+}
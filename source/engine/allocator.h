@@ -1,20 +1,42 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <list>
+#include <vector>
 #include "singly_linked_list.h"
+#include "platform/gcc.h"
 
 constexpr std::size_t DefaultAlignment = 8;
 
+struct FragmentationStats {
+    std::size_t freeBytes { 0 };
+    std::size_t largestFreeBlock { 0 };
+    std::size_t freeBlockCount { 0 };
+
+    // 0 when all free memory is one block, approaches 1 as free memory is scattered over small blocks
+    [[nodiscard]] float ratio() const {
+        return freeBytes == 0 ? 0.0f : 1.0f - static_cast<float>(largestFreeBlock) / static_cast<float>(freeBytes);
+    }
+};
+
 class Allocator {
 public:
     explicit Allocator(const std::size_t totalSize)
         : mTotalSize(totalSize)
     {}
 
+    virtual ~Allocator() = default;
+
     virtual void* allocate(std::size_t size, std::size_t alignment) = 0;
     virtual void deallocate(void* ptr) = 0;
+
+    [[nodiscard]] constexpr ALWAYS_INLINE std::size_t used() const { return mUsed; }
+    [[nodiscard]] constexpr ALWAYS_INLINE std::size_t peak() const { return mPeak; }
+    [[nodiscard]] constexpr ALWAYS_INLINE std::size_t totalSize() const { return mTotalSize; }
 protected:
     bool mFreeOnDestruction { false };
     std::size_t mTotalSize { 0 };
@@ -31,6 +53,8 @@ public:
     void* allocate(std::size_t size, std::size_t alignment) override;
     void deallocate(void* pointer) override;
     void reset();
+
+    [[nodiscard]] FragmentationStats fragmentation() const;
 private:
     struct FreeBlock {
         std::size_t size { 0 };
@@ -38,11 +62,206 @@ private:
 
     struct AllocatedBlock {
         std::size_t size;
-        uint8_t padding;
+        std::size_t padding;
     };
 
     using Node = SinglyLinkedList<FreeBlock>::Node;
     SinglyLinkedList<FreeBlock> mFreeBlocks = SinglyLinkedList<FreeBlock>();
 
     void tryMergeFreedBlock(Node* freeNode, Node* previousNode);
-};
\ No newline at end of file
+};
+
+// Two-Level Segregated Fit allocator. Free blocks are bucketed by size in a first level of power of two classes,
+// each split linearly in a second level. Two bitmaps find the smallest fitting bucket, so allocate and deallocate
+// are O(1) and freed blocks are merged with their physical neighbours right away.
+class TlsfAllocator : public Allocator {
+public:
+    explicit TlsfAllocator(std::size_t size);
+    ~TlsfAllocator();
+
+    TlsfAllocator(const TlsfAllocator&) = delete;
+    TlsfAllocator& operator=(const TlsfAllocator&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment) override;
+    void deallocate(void* pointer) override;
+    void reset();
+
+    [[nodiscard]] FragmentationStats fragmentation() const;
+private:
+    static constexpr std::size_t AlignmentLog2 = 4;
+    static constexpr std::size_t BlockAlignment = 1 << AlignmentLog2;
+
+    static constexpr std::size_t SlIndexCountLog2 = 4;
+    static constexpr std::size_t SlIndexCount = 1 << SlIndexCountLog2;
+
+    // Blocks below SmallBlockSize all live in the first level, split in SlIndexCount linear classes
+    static constexpr std::size_t FlIndexShift = SlIndexCountLog2 + AlignmentLog2;
+    static constexpr std::size_t FlIndexMax = 32;
+    static constexpr std::size_t FlIndexCount = FlIndexMax - FlIndexShift + 1;
+    static constexpr std::size_t SmallBlockSize = 1 << FlIndexShift;
+
+    struct BlockHeader {
+        // Payload size, the lowest bit marks the block as free
+        std::size_t size;
+        BlockHeader *previousPhysical;
+
+        // Only valid while the block is free, they overlap the payload
+        BlockHeader *nextFree;
+        BlockHeader *previousFree;
+    };
+
+    static constexpr std::size_t BlockHeaderSize = offsetof(BlockHeader, nextFree);
+    static constexpr std::size_t MinBlockSize = sizeof(BlockHeader) - BlockHeaderSize;
+    static constexpr std::size_t FreeBit = 1;
+
+    uint32_t mFlBitmap { 0 };
+    std::array<uint32_t, FlIndexCount> mSlBitmaps {};
+    std::array<std::array<BlockHeader*, SlIndexCount>, FlIndexCount> mFreeBlocks {};
+
+    static ALWAYS_INLINE std::size_t blockSize(const BlockHeader *block) { return block->size & ~FreeBit; }
+    static ALWAYS_INLINE bool isFree(const BlockHeader *block) { return block->size & FreeBit; }
+    static ALWAYS_INLINE std::byte* payload(BlockHeader *block) { return reinterpret_cast<std::byte*>(block) + BlockHeaderSize; }
+
+    static ALWAYS_INLINE BlockHeader* nextPhysical(BlockHeader *block) {
+        return reinterpret_cast<BlockHeader*>(payload(block) + blockSize(block));
+    }
+
+    static void mapping(std::size_t size, uint32_t &fl, uint32_t &sl);
+    static void mappingSearch(std::size_t size, uint32_t &fl, uint32_t &sl);
+
+    BlockHeader* findFreeBlock(std::size_t size);
+    void insertFreeBlock(BlockHeader *block);
+    void removeFreeBlock(BlockHeader *block);
+
+    // Splits the tail of a used block off as a new free block when it is large enough to hold one
+    void trimBlock(BlockHeader *block, std::size_t size);
+    BlockHeader* mergeWithNeighbours(BlockHeader *block);
+};
+
+
+// Bump allocator for data that only lives for a frame. The pool is split in two halves, allocations of a frame come
+// from the active half and deallocate is a no-op. swap() makes the other half active and resets it in O(1), so the
+// data of the previous frame stays valid for one more frame.
+class FrameArena : public Allocator {
+public:
+    explicit FrameArena(std::size_t size);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment) override;
+    void deallocate(void*) override {}
+
+    void swap();
+
+    [[nodiscard]] constexpr ALWAYS_INLINE std::size_t frameCapacity() const { return mFrameSize; }
+    [[nodiscard]] constexpr ALWAYS_INLINE std::size_t lastFramePeak() const { return mLastFramePeak; }
+private:
+    std::size_t mFrameSize;
+    std::size_t mLastFramePeak { 0 };
+    uint32_t mFrameIndex { 0 };
+
+    std::byte *mCurrent { nullptr };
+};
+
+
+// Thread-safe front end over a single threaded allocator. Small requests are served from per-thread magazines of
+// fixed size classes, a magazine only touches the lock protected central heap to refill or flush a batch of blocks.
+// Large or over aligned requests go to the backing allocator under the lock.
+// The magazines of a thread are bound to the first caching allocator the thread uses, other instances skip the cache.
+class ThreadCachingAllocator : public Allocator {
+public:
+    explicit ThreadCachingAllocator(Allocator &backing);
+    ~ThreadCachingAllocator();
+
+    ThreadCachingAllocator(const ThreadCachingAllocator&) = delete;
+    ThreadCachingAllocator& operator=(const ThreadCachingAllocator&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment) override;
+    void deallocate(void* pointer) override;
+
+    // used() counts the bytes handed out, this counts the slabs and large blocks taken from the backing allocator
+    [[nodiscard]] std::size_t footprint() const {
+        std::lock_guard lock(mMutex);
+        return mFootprint;
+    }
+private:
+    static constexpr std::size_t SizeClassCount = 12;
+    static constexpr std::array<uint32_t, SizeClassCount> SizeClasses { 16, 32, 48, 64, 80, 96, 112, 128, 192, 256, 384, 512 };
+    static constexpr uint32_t LargeClass = SizeClassCount;
+
+    static constexpr std::size_t HeaderSize = 16;
+    static constexpr uint32_t MagazineCapacity = 64;
+    static constexpr uint32_t TransferCount = MagazineCapacity / 2;
+    // A slab whose blocks are all back on the central list is released once the class has this many free blocks
+    static constexpr uint32_t ReleaseThreshold = TransferCount;
+
+    struct BlockHeader {
+        uint32_t sizeClass;
+        // Distance from the slab, or from the backing allocation of a large block, to the payload
+        uint32_t offset;
+        // Requested size of a large block
+        uint64_t size;
+    };
+    static_assert(sizeof(BlockHeader) <= HeaderSize);
+
+    struct SlabHeader {
+        uint32_t sizeClass;
+        // Blocks of the slab sitting on the central free list
+        uint32_t freeCount;
+        uint32_t index;
+    };
+
+    // Doubly linked so the blocks of a released slab can be unlinked from anywhere in the list
+    struct FreeBlock {
+        FreeBlock *next;
+        FreeBlock *prev;
+    };
+
+    struct Magazine {
+        uint32_t count { 0 };
+        std::array<void*, MagazineCapacity> blocks;
+    };
+
+    struct ThreadCache {
+        ThreadCachingAllocator *owner { nullptr };
+        std::array<Magazine, SizeClassCount> magazines;
+
+        ~ThreadCache();
+    };
+
+    static thread_local ThreadCache sThreadCache;
+
+    Allocator &mBacking;
+
+    mutable std::mutex mMutex;
+    std::array<FreeBlock*, SizeClassCount> mCentralFreeLists {};
+    std::array<uint32_t, SizeClassCount> mCentralFreeCounts {};
+    std::vector<SlabHeader*> mSlabs;
+    std::size_t mFootprint { 0 };
+
+    static ALWAYS_INLINE BlockHeader* header(void *pointer) {
+        return reinterpret_cast<BlockHeader*>(static_cast<std::byte*>(pointer) - HeaderSize);
+    }
+
+    static ALWAYS_INLINE SlabHeader* slab(void *pointer) {
+        return reinterpret_cast<SlabHeader*>(static_cast<std::byte*>(pointer) - header(pointer)->offset);
+    }
+
+    static uint32_t sizeClass(std::size_t size);
+    ThreadCache* threadCache();
+
+    void refill(Magazine &magazine, uint32_t sizeClass);
+    void flush(Magazine &magazine, uint32_t sizeClass, uint32_t count);
+
+    void carveSlab(uint32_t sizeClass);
+    void releaseSlab(SlabHeader *slab);
+    void pushFree(uint32_t sizeClass, FreeBlock *block);
+    void unlinkFree(uint32_t sizeClass, FreeBlock *block);
+
+    void addUsed(std::size_t size);
+    void subtractUsed(std::size_t size);
+
+    void* allocateLarge(std::size_t size, std::size_t alignment);
+};
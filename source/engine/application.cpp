@@ -1,5 +1,8 @@
 #include "application.h"
 
+#include <cassert>
+#include <chrono>
+
 #include "game/universe.h"
 #include "engine.h"
 #include "logging.h"
@@ -23,21 +26,31 @@ bool Application::initialize() {
 
     sInitialized = true;
 
-    mScene = game::Universe::createInstance(Engine::instance().allocator());
-    mScene->initialize();
-
+    // Before the scene, so its textures are decoded on the job system
     Engine::initialize();
 
+    mScene = game::Universe::createInstance(Engine::instance().allocator(MemoryTag::Untagged));
+    mScene->initialize();
+
     return true;
 }
 
 void Application::run() {
+    auto previousTime = std::chrono::steady_clock::now();
+
     while (!mWindow.closed()) {
         mWindow.pollEvents();
 
+        auto currentTime = std::chrono::steady_clock::now();
+        auto dt = std::chrono::duration<float>(currentTime - previousTime).count();
+        previousTime = currentTime;
+
+        mScene->update(dt);
         mScene->render();
 
         mWindow.swapBuffers();
+
+        Engine::endFrame();
     }
 }
 
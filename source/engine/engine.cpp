@@ -4,15 +4,45 @@
 #include "gfx/texture_manager.h"
 #include "gfx/material_manager.h"
 #include "gfx/mesh_manager.h"
+#include "logging.h"
 
 
 void Engine::initialize() {
+    instance().mJobSystem.initialize();
     gfx::MeshManager::instance().initialize();
 }
 
 void Engine::shutdown() {
+    auto &frameArena = instance().mFrameArena;
+    Logger::info("Frame arena peak usage {} of {} bytes", frameArena.peak(), frameArena.frameCapacity());
+
     gfx::ShaderManager::instance().cleanup();
     gfx::TextureManager::instance().cleanup();
     gfx::MaterialManager::instance().cleanup();
     gfx::MeshManager::instance().cleanup();
+
+    instance().mJobSystem.shutdown();
+}
+
+void Engine::endFrame() {
+    auto &engine = instance();
+    engine.mFrameArena.swap();
+
+    engine.mFrameCount++;
+    if (engine.mMemoryReportInterval > 0 && engine.mFrameCount % engine.mMemoryReportInterval == 0) {
+        logMemoryStats();
+    }
+}
+
+void Engine::logMemoryStats() {
+    auto &engine = instance();
+
+    MemoryTracker::instance().logStats();
+
+    auto fragmentation = engine.mHeap.fragmentation();
+    Logger::info("Heap: {} of {} bytes used, peak {} bytes, {} free blocks, largest free block {} bytes, fragmentation {}",
+                 engine.mHeap.used(), engine.mHeap.totalSize(), engine.mHeap.peak(), fragmentation.freeBlockCount,
+                 fragmentation.largestFreeBlock, fragmentation.ratio());
+
+    Logger::info("Frame arena: {} of {} bytes used last frame", engine.mFrameArena.lastFramePeak(), engine.mFrameArena.frameCapacity());
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "allocator.h"
+#include "job_system.h"
+#include "memory_tracker.h"
 #include "platform/gcc.h"
 
 class Engine {
@@ -13,14 +15,59 @@ public:
     Engine(const Engine&) = delete;
     Engine& operator=(const Engine&) = delete;
 
-    constexpr ALWAYS_INLINE ListAllocator& allocator() {
+    // Safe to use from any thread
+    constexpr ALWAYS_INLINE ThreadCachingAllocator& allocator() {
         return mAllocator;
     }
 
+    // Same heap, but allocations are attributed to the tag in the memory statistics
+    constexpr ALWAYS_INLINE TaggedAllocator& allocator(MemoryTag tag) {
+        return mTaggedAllocators[static_cast<std::size_t>(tag)];
+    }
+
+    constexpr ALWAYS_INLINE FrameArena& frameArena() {
+        return mFrameArena;
+    }
+
+    constexpr ALWAYS_INLINE JobSystem& jobSystem() {
+        return mJobSystem;
+    }
+
     static void initialize();
     static void shutdown();
+
+    // Called once the frame is presented, releases the transient data of the frame before
+    static void endFrame();
+
+    // Logs the tag statistics, heap usage and fragmentation. Must not run while jobs are allocating.
+    static void logMemoryStats();
+
+    // Dumps the memory statistics every interval frames, 0 disables the dump
+    static void setMemoryReportInterval(uint32_t frames) {
+        instance().mMemoryReportInterval = frames;
+    }
 private:
     Engine() = default;
 
-    ListAllocator mAllocator { 1024 * 1024 };
+    TlsfAllocator mHeap { 1024 * 1024 };
+    ThreadCachingAllocator mAllocator { mHeap };
+
+    static_assert(MemoryTagCount == 5);
+    std::array<TaggedAllocator, MemoryTagCount> mTaggedAllocators {
+        TaggedAllocator { mAllocator, MemoryTag::Untagged },
+        TaggedAllocator { mAllocator, MemoryTag::Ecs },
+        TaggedAllocator { mAllocator, MemoryTag::Gfx },
+        TaggedAllocator { mAllocator, MemoryTag::Lua },
+        TaggedAllocator { mAllocator, MemoryTag::Terrain },
+    };
+
+    FrameArena mFrameArena { 2 * 1024 * 1024 };
+    JobSystem mJobSystem;
+
+#ifdef NDEBUG
+    uint32_t mMemoryReportInterval { 0 };
+#else
+    uint32_t mMemoryReportInterval { 3600 };
+#endif
+    uint32_t mFrameCount { 0 };
 };
\ No newline at end of file
@@ -2,8 +2,8 @@
 #include "xxhash64.h"
 #include "xxhash32.h"
 
-Hash64::Hash64(const std::string &value) {
-    mHash = XXHash64::hash(value.c_str(), value.length(), 347183);
+Hash64::Hash64(std::string_view value) {
+    mHash = XXHash64::hash(value.data(), value.length(), 347183);
 }
 
 Hash32::Hash32(const uint32_t &value) {
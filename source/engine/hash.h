@@ -2,14 +2,14 @@
 
 #include <cstdint>
 #include <compare>
-#include <string>
+#include <string_view>
 #include <stdexcept>
 #include "platform/gcc.h"
 
 class Hash64 {
 public:
     Hash64() = default;
-    explicit Hash64(const std::string &value);
+    explicit Hash64(std::string_view value);
 
     bool operator==(const Hash64 &rhs) const = default;
     auto operator<=>(const Hash64 rhs) const { return mHash <=> rhs.mHash; }
@@ -36,6 +36,6 @@ private:
 template<>
 struct std::hash<Hash64> {
     auto operator()(const Hash64 hash64) const -> size_t {
-        return hash<uint64_t>()(hash64.value());
+        return hash64.value();
     }
 };
\ No newline at end of file
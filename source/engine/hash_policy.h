@@ -0,0 +1,68 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "hash.h"
+#include "xxhash64.h"
+#include "platform/gcc.h"
+
+// Hashing policies turn a key into 64 bits whose high bits are well mixed, HashMap picks the slot from the top bits.
+
+// Multiplies by 2^64 / phi. Cheap and spreads dense integer ids like object and resource ids over the table.
+struct FibonacciHash {
+    template<typename K> requires std::is_integral_v<K> || std::is_enum_v<K>
+    ALWAYS_INLINE uint64_t operator()(K key) const {
+        return static_cast<uint64_t>(key) * 11400714819323198485ull;
+    }
+};
+
+// Keys that already carry a Hash64, such as Path, are used as is
+struct PrehashedHash {
+    ALWAYS_INLINE uint64_t operator()(Hash64 hash) const {
+        return hash.value();
+    }
+
+    template<typename K> requires requires(const K &key) { { key.hash() } -> std::same_as<Hash64>; }
+    ALWAYS_INLINE uint64_t operator()(const K &key) const {
+        return key.hash().value();
+    }
+};
+
+// Strings hash their characters, so lookups can pass a string_view or literal without building a std::string
+struct StringHash {
+    ALWAYS_INLINE uint64_t operator()(std::string_view key) const {
+        return Hash64(key).value();
+    }
+};
+
+// Fallback for plain data keys, hashes the object representation. Only valid when equal keys have equal bytes, so
+// types with padding, floats or owned memory need a policy of their own.
+struct ByteHash {
+    template<typename K> requires std::has_unique_object_representations_v<K>
+    uint64_t operator()(const K &key) const {
+        return XXHash64::hash(&key, sizeof(K), 283991);
+    }
+};
+
+template<typename K>
+struct DefaultHash : ByteHash {
+    static_assert(std::has_unique_object_representations_v<K>, "Key type has no DefaultHash, pass a Hasher to HashMap");
+};
+
+template<typename K> requires std::is_integral_v<K> || std::is_enum_v<K>
+struct DefaultHash<K> : FibonacciHash {};
+
+template<>
+struct DefaultHash<Hash64> : PrehashedHash {};
+
+template<>
+struct DefaultHash<std::string> : StringHash {};
+
+template<>
+struct DefaultHash<std::string_view> : StringHash {};
+
+template<typename K> requires requires(const K &key) { { key.hash() } -> std::same_as<Hash64>; }
+struct DefaultHash<K> : PrehashedHash {};
@@ -0,0 +1,188 @@
+#include "job_system.h"
+
+void WorkStealingQueue::push(Job &&job) {
+    std::lock_guard lock(mMutex);
+    mJobs.push_back(std::move(job));
+}
+
+bool WorkStealingQueue::pop(Job &job) {
+    std::lock_guard lock(mMutex);
+    if (mJobs.empty()) {
+        return false;
+    }
+
+    job = std::move(mJobs.back());
+    mJobs.pop_back();
+
+    return true;
+}
+
+bool WorkStealingQueue::steal(Job &job) {
+    std::lock_guard lock(mMutex);
+    if (mJobs.empty()) {
+        return false;
+    }
+
+    job = std::move(mJobs.front());
+    mJobs.pop_front();
+
+    return true;
+}
+
+JobSystem::~JobSystem() {
+    shutdown();
+}
+
+void JobSystem::initialize(uint32_t workerCount) {
+    if (mRunning) {
+        return;
+    }
+
+    if (workerCount == 0) {
+        auto hardwareThreads = std::thread::hardware_concurrency();
+        // At least one worker, jobs nobody waits on would otherwise never run
+        workerCount = hardwareThreads > 2 ? hardwareThreads - 1 : 1;
+    }
+
+    mRunning = true;
+
+    // Queue 0 belongs to the thread that initializes the job system
+    sQueueIndex = 0;
+    for (uint32_t i = 0; i <= workerCount; i++) {
+        mQueues.push_back(std::make_unique<WorkStealingQueue>());
+    }
+
+    for (uint32_t i = 1; i <= workerCount; i++) {
+        mWorkers.emplace_back(&JobSystem::workerLoop, this, static_cast<int>(i));
+    }
+}
+
+void JobSystem::shutdown() {
+    if (!mRunning) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(mSleepMutex);
+        mRunning = false;
+    }
+    mSleepCondition.notify_all();
+
+    for (auto &worker : mWorkers) {
+        worker.join();
+    }
+
+    mWorkers.clear();
+    mQueues.clear();
+}
+
+void JobSystem::countJob(Job &job, JobCounter *counter) {
+    if (counter) {
+        counter->mValue.fetch_add(1, std::memory_order_relaxed);
+
+        job = [job = std::move(job), counter]() {
+            job();
+            counter->mValue.fetch_sub(1, std::memory_order_release);
+        };
+    }
+}
+
+void JobSystem::enqueue(WorkStealingQueue &queue, Job &&job) {
+    // Counted under the sleep mutex so a worker can't miss the wakeup between checking the count and waiting, and
+    // before the push so a worker running the job never decrements the count below zero
+    {
+        std::lock_guard lock(mSleepMutex);
+        mPendingJobs.fetch_add(1, std::memory_order_release);
+    }
+
+    queue.push(std::move(job));
+    mSleepCondition.notify_one();
+}
+
+void JobSystem::schedule(Job &&job, JobCounter *counter) {
+    countJob(job, counter);
+
+    if (mQueues.empty()) {
+        // Not initialized, run inline
+        job();
+        return;
+    }
+
+    // Workers keep their own jobs local, other threads spread their jobs over all queues
+    auto queueIndex = sQueueIndex >= 0
+            ? static_cast<std::size_t>(sQueueIndex)
+            : mNextQueue.fetch_add(1, std::memory_order_relaxed) % mQueues.size();
+
+    enqueue(*mQueues[queueIndex], std::move(job));
+}
+
+void JobSystem::scheduleBackground(Job &&job, JobCounter *counter) {
+    countJob(job, counter);
+
+    if (mWorkers.empty()) {
+        job();
+        return;
+    }
+
+    enqueue(mBackgroundQueue, std::move(job));
+}
+
+void JobSystem::wait(const JobCounter &counter) {
+    auto queueIndex = sQueueIndex >= 0 ? sQueueIndex : 0;
+
+    while (!counter.done()) {
+        if (!tryRunJob(queueIndex)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::tryRunJob(int queueIndex) {
+    if (mQueues.empty()) {
+        return false;
+    }
+
+    Job job;
+    bool found = mQueues[queueIndex]->pop(job);
+
+    for (std::size_t i = 1; !found && i < mQueues.size(); i++) {
+        auto victim = (queueIndex + i) % mQueues.size();
+        found = mQueues[victim]->steal(job);
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    mPendingJobs.fetch_sub(1, std::memory_order_relaxed);
+    job();
+
+    return true;
+}
+
+bool JobSystem::tryRunBackgroundJob() {
+    Job job;
+    if (!mBackgroundQueue.steal(job)) {
+        return false;
+    }
+
+    mPendingJobs.fetch_sub(1, std::memory_order_relaxed);
+    job();
+
+    return true;
+}
+
+void JobSystem::workerLoop(int queueIndex) {
+    sQueueIndex = queueIndex;
+
+    while (mRunning) {
+        if (tryRunJob(queueIndex) || tryRunBackgroundJob()) {
+            continue;
+        }
+
+        std::unique_lock lock(mSleepMutex);
+        mSleepCondition.wait(lock, [this]() {
+            return !mRunning || mPendingJobs.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "platform/gcc.h"
+
+using Job = std::function<void()>;
+
+// Counts the unfinished jobs of a batch, wait on it to join the batch
+class JobCounter {
+public:
+    [[nodiscard]] ALWAYS_INLINE bool done() const { return mValue.load(std::memory_order_acquire) == 0; }
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> mValue { 0 };
+};
+
+// Per thread job queue. The owning thread pushes and pops at the back, other threads steal from the front so
+// they take the oldest and usually largest pieces of work.
+class WorkStealingQueue {
+public:
+    void push(Job &&job);
+    bool pop(Job &job);
+    bool steal(Job &job);
+private:
+    std::mutex mMutex;
+    std::deque<Job> mJobs;
+};
+
+class JobSystem {
+public:
+    JobSystem() = default;
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Starts one worker per remaining hardware thread, the calling thread becomes queue 0 and helps out while waiting
+    void initialize(uint32_t workerCount = 0);
+    void shutdown();
+
+    void schedule(Job &&job, JobCounter *counter = nullptr);
+
+    // For long running work that must stay off the calling thread, like decoding assets. Only workers run these and
+    // only when they have no other jobs, wait never picks them up on the thread that waits.
+    void scheduleBackground(Job &&job, JobCounter *counter = nullptr);
+
+    // Runs pending jobs on the calling thread until every job of the counter has finished
+    void wait(const JobCounter &counter);
+
+    // Splits [0, count) into batches of batchSize and calls callback(begin, end) for every batch in parallel
+    template<typename Callback>
+    void parallelFor(std::size_t count, std::size_t batchSize, Callback &&callback) {
+        if (count == 0) {
+            return;
+        }
+
+        if (count <= batchSize || mWorkers.empty()) {
+            callback(std::size_t { 0 }, count);
+            return;
+        }
+
+        JobCounter counter;
+        for (std::size_t begin = 0; begin < count; begin += batchSize) {
+            auto end = std::min(begin + batchSize, count);
+            schedule([&callback, begin, end]() { callback(begin, end); }, &counter);
+        }
+
+        wait(counter);
+    }
+
+    [[nodiscard]] ALWAYS_INLINE std::size_t threadCount() const { return mQueues.size(); }
+private:
+    std::vector<std::unique_ptr<WorkStealingQueue>> mQueues;
+    WorkStealingQueue mBackgroundQueue;
+    std::vector<std::thread> mWorkers;
+
+    std::atomic<bool> mRunning { false };
+    std::atomic<uint32_t> mPendingJobs { 0 };
+    std::atomic<uint32_t> mNextQueue { 0 };
+
+    std::mutex mSleepMutex;
+    std::condition_variable mSleepCondition;
+
+    static inline thread_local int sQueueIndex { -1 };
+
+    void workerLoop(int queueIndex);
+    bool tryRunJob(int queueIndex);
+    bool tryRunBackgroundJob();
+
+    static void countJob(Job &job, JobCounter *counter);
+    void enqueue(WorkStealingQueue &queue, Job &&job);
+};
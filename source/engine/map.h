@@ -1,21 +1,67 @@
 #pragma once
 
+#include <bit>
 #include <cstdint>
+#include <cstring>
+#include <utility>
 #include "allocator.h"
-#include "xxhash32.h"
+#include "hash_policy.h"
+#include "platform/gcc.h"
 
-template<typename K, typename T>
-class HashMap {
-private:
-    struct KeyEntry {
-        alignas (K) char key[sizeof(K)];
-        bool valid;
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace detail {
+    constexpr uint32_t GroupWidth = 16;
+    constexpr int8_t ControlEmpty = -128;
+
+    // Sixteen control bytes compared at once, bit i of a match is set when byte i matches
+    class ControlGroup {
+    public:
+        explicit ControlGroup(const int8_t *control) {
+#ifdef __SSE2__
+            mControl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+#else
+            std::memcpy(mControl, control, GroupWidth);
+#endif
+        }
+
+        [[nodiscard]] ALWAYS_INLINE uint32_t match(int8_t value) const {
+#ifdef __SSE2__
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(mControl, _mm_set1_epi8(value))));
+#else
+            uint32_t result = 0;
+            for (uint32_t i = 0; i < GroupWidth; i++) {
+                result |= static_cast<uint32_t>(mControl[i] == value) << i;
+            }
+
+            return result;
+#endif
+        }
+
+        [[nodiscard]] ALWAYS_INLINE uint32_t matchEmpty() const {
+            return match(ControlEmpty);
+        }
+    private:
+#ifdef __SSE2__
+        __m128i mControl;
+#else
+        int8_t mControl[GroupWidth];
+#endif
     };
+}
 
+// Open addressing map in the style of a Swiss table. Every slot has a control byte that is either empty or holds
+// 7 bits of the hash, lookups compare a group of 16 control bytes in one go and only compare keys on a match.
+// Groups are probed linearly, so removal shifts the following entries back instead of leaving tombstones.
+// The hasher is a policy from hash_policy.h, lookups accept any key type the hasher and K's operator== support.
+template<typename K, typename T, typename Hasher = DefaultHash<K>>
+class HashMap {
 public:
     class Iterator {
     public:
-        Iterator(HashMap<K, T> &map, std::size_t index)
+        Iterator(HashMap &map, std::size_t index)
             : mMap(map)
             , mIndex(index)
         {
@@ -26,7 +72,7 @@ public:
 
         Iterator& operator++() {
             mIndex++;
-            while (mIndex < mMap.mCapacity && !mMap.mKeys[mIndex].valid) {
+            while (mIndex < mMap.mCapacity && !mMap.isFull(mIndex)) {
                 mIndex++;
             }
 
@@ -52,39 +98,25 @@ public:
         }
 
         K& key() {
-            return *reinterpret_cast<K*>(mMap.mKeys[mIndex].key);
+            return mMap.mKeys[mIndex];
         }
 
         T& value() {
             return mMap.mValues[mIndex];
         }
     private:
-        HashMap<K, T> &mMap;
+        HashMap &mMap;
         std::size_t mIndex;
     };
 
     explicit HashMap(Allocator &allocator, uint32_t initialCapacity = 16)
-        : mAllocator(allocator)
+        : mAllocator(&allocator)
     {
-        initialize(initialCapacity);
+        initialize(std::bit_ceil(std::max(initialCapacity, detail::GroupWidth)));
     }
 
     ~HashMap() {
-        if (!mKeys) {
-            return;
-        }
-        
-        for (auto i = 0; i < mCapacity; i++) {
-            if (mKeys[i].valid) {
-                reinterpret_cast<K*>(mKeys[i].key)->~K();
-                auto &value = mValues[i];
-                value.~T();
-                mKeys[i].valid = false;
-            }
-        }
-
-        mAllocator.deallocate(mKeys);
-        mAllocator.deallocate(mValues);
+        release();
     }
 
     HashMap(const HashMap &rhs) = delete;
@@ -92,44 +124,51 @@ public:
 
     HashMap(HashMap &&rhs) noexcept
         : mAllocator(rhs.mAllocator)
-        , mKeys(rhs.mKeys)
-        , mValues(rhs.mValues)
-        , mCapacity(rhs.mCapacity)
         , mSize(rhs.mSize)
+        , mCapacity(rhs.mCapacity)
         , mMask(rhs.mMask)
+        , mShift(rhs.mShift)
+        , mControl(rhs.mControl)
+        , mKeys(rhs.mKeys)
+        , mValues(rhs.mValues)
     {
-        rhs.mKeys = nullptr;
-        rhs.mValues = nullptr;
-        rhs.mCapacity = 0;
-        rhs.mSize = 0;
-        rhs.mMask = 0;
+        rhs.reset();
     }
 
     HashMap& operator=(HashMap &&rhs) noexcept {
+        if (this == &rhs) {
+            return *this;
+        }
+
+        release();
+
         mAllocator = rhs.mAllocator;
-        mKeys = rhs.mKeys;
-        mValues = rhs.mValues;
-        mCapacity = rhs.mCapacity;
         mSize = rhs.mSize;
+        mCapacity = rhs.mCapacity;
         mMask = rhs.mMask;
+        mShift = rhs.mShift;
+        mControl = rhs.mControl;
+        mKeys = rhs.mKeys;
+        mValues = rhs.mValues;
 
-        rhs.mKeys = nullptr;
-        rhs.mValues = nullptr;
-        rhs.mCapacity = 0;
-        rhs.mSize = 0;
-        rhs.mMask = 0;
+        rhs.reset();
 
         return *this;
     }
 
+    // Inserts a default constructed value when the key is missing
     T& operator[](const K &key) {
         auto index = findIndex(key);
+        if (index == mCapacity) {
+            index = insertNew(key, T {});
+        }
+
         return mValues[index];
     }
 
     Iterator begin() {
-        for (auto i = 0; i < mCapacity; ++i) {
-            if (mKeys[i].valid) {
+        for (uint32_t i = 0; i < mCapacity; ++i) {
+            if (isFull(i)) {
                 return Iterator(*this, i);
             }
         }
@@ -142,30 +181,13 @@ public:
     }
 
     void insert(const K &key, const T &value) {
-        if (mSize >= mCapacity * 0.75) {
-            grow(mCapacity * 2);
-        }
-
-        const uint32_t hash = hashKey(key);
-        auto index = hash % mMask;
-
-        while (mKeys[index].valid) {
-            index++;
-        }
-
-        if (index == mCapacity) {
-            index = 0;
-            while (mKeys[index].valid) {
-                index++;
-            }
+        auto index = findIndex(key);
+        if (index != mCapacity) {
+            mValues[index] = value;
+            return;
         }
 
-        new (&mKeys[index].key) K(key);
-        mValues[index] = value;
-
-        mKeys[index].valid = true;
-
-        mSize++;
+        insertNew(key, value);
     }
 
     void remove(const K &key) {
@@ -174,18 +196,35 @@ public:
             return;
         }
 
-        mKeys[index].valid = false;
+        mKeys[index].~K();
         mValues[index].~T();
         mSize--;
 
-        index = (index + 1) % mMask; // wrap around
-        while (mKeys[index].valid) {
-            rehash(index);
-            index = (index + 1) % mCapacity;
+        // Backward shift: pull every following entry of the run that may live in the hole into it
+        auto hole = index;
+        auto next = (index + 1) & mMask;
+
+        while (isFull(next)) {
+            auto home = position(hashKey(mKeys[next]));
+
+            if (((next - home) & mMask) >= ((next - hole) & mMask)) {
+                new (mKeys + hole) K(std::move(mKeys[next]));
+                new (mValues + hole) T(std::move(mValues[next]));
+                mKeys[next].~K();
+                mValues[next].~T();
+
+                setControl(hole, mControl[next]);
+                hole = next;
+            }
+
+            next = (next + 1) & mMask;
         }
+
+        setControl(hole, detail::ControlEmpty);
     }
 
-    Iterator find(const K &key) {
+    template<typename Q = K>
+    Iterator find(const Q &key) {
         auto index = findIndex(key);
         if (index == mCapacity) {
             return end();
@@ -194,104 +233,206 @@ public:
         return Iterator(*this, index);
     }
 
-    bool contains(const K &key) const {
+    // Pointer to the value or nullptr when the key is missing, usable on const maps
+    template<typename Q = K>
+    const T* get(const Q &key) const {
+        auto index = findIndex(key);
+        return index == mCapacity ? nullptr : mValues + index;
+    }
+
+    template<typename Q = K>
+    bool contains(const Q &key) const {
         auto index = findIndex(key);
         return index != mCapacity;
     }
 
+    void clear() {
+        if (!mControl) {
+            return;
+        }
+
+        for (uint32_t i = 0; i < mCapacity; i++) {
+            if (isFull(i)) {
+                mKeys[i].~K();
+                mValues[i].~T();
+            }
+        }
+
+        std::memset(mControl, static_cast<uint8_t>(detail::ControlEmpty), mCapacity + detail::GroupWidth);
+        mSize = 0;
+    }
+
+    [[nodiscard]] constexpr ALWAYS_INLINE uint32_t size() const { return mSize; }
 private:
-    Allocator &mAllocator;
+    Allocator *mAllocator;
     uint32_t mSize { 0 };
     uint32_t mCapacity { 0 };
     uint32_t mMask { 0 };
+    uint32_t mShift { 0 };
 
-    KeyEntry *mKeys { nullptr };
+    // One control byte per slot, followed by a copy of the first group so a group can be loaded at any slot
+    int8_t *mControl { nullptr };
+    K *mKeys { nullptr };
     T *mValues { nullptr };
 
+    [[nodiscard]] ALWAYS_INLINE bool isFull(uint32_t index) const {
+        return mControl[index] >= 0;
+    }
+
+    // The slot comes from the top bits of the hash and the control byte from the 7 bits below them
+    [[nodiscard]] ALWAYS_INLINE uint32_t position(uint64_t hash) const {
+        return static_cast<uint32_t>(hash >> mShift);
+    }
+
+    [[nodiscard]] ALWAYS_INLINE int8_t control(uint64_t hash) const {
+        return static_cast<int8_t>(hash >> (mShift - 7) & 0x7f);
+    }
+
+    ALWAYS_INLINE void setControl(uint32_t index, int8_t value) {
+        mControl[index] = value;
+        if (index < detail::GroupWidth) {
+            mControl[mCapacity + index] = value;
+        }
+    }
+
     void initialize(uint32_t capacity) {
         mSize = 0;
         mCapacity = capacity;
         mMask = mCapacity - 1;
+        mShift = 64 - std::countr_zero(mCapacity);
 
-        mKeys = static_cast<KeyEntry*>(mAllocator.allocate(sizeof(KeyEntry) * (mCapacity + 1), alignof(KeyEntry)));
-        mValues = static_cast<T*>(mAllocator.allocate(sizeof(T) * mCapacity, alignof(T)));
+        mControl = static_cast<int8_t*>(mAllocator->allocate(mCapacity + detail::GroupWidth, detail::GroupWidth));
+        mKeys = static_cast<K*>(mAllocator->allocate(sizeof(K) * mCapacity, alignof(K)));
+        mValues = static_cast<T*>(mAllocator->allocate(sizeof(T) * mCapacity, alignof(T)));
 
-        for (uint32_t i = 0; i <= mCapacity; i++) {
-            mKeys[i].valid = false;
-        }
+        std::memset(mControl, static_cast<uint8_t>(detail::ControlEmpty), mCapacity + detail::GroupWidth);
     }
 
-    void grow(uint32_t newCapacity) {
-        HashMap<K, T> newMap(mAllocator, newCapacity);
+    void release() {
+        if (!mControl) {
+            return;
+        }
 
         for (uint32_t i = 0; i < mCapacity; i++) {
-            if (mKeys[i].valid) {
-                newMap.insert(*reinterpret_cast<K *>(&mKeys[i].key), mValues[i]);
+            if (isFull(i)) {
+                mKeys[i].~K();
+                mValues[i].~T();
             }
         }
 
-        *this = std::move(newMap);
+        mAllocator->deallocate(mControl);
+        mAllocator->deallocate(mKeys);
+        mAllocator->deallocate(mValues);
+
+        reset();
     }
 
-    uint32_t findEmptyKeyValue(const K &key, uint32_t endIndex) const {
-        const uint32_t hash = hashKey(key);
-        auto index = hash % mMask;
+    void reset() {
+        mControl = nullptr;
+        mKeys = nullptr;
+        mValues = nullptr;
+        mCapacity = 0;
+        mSize = 0;
+        mMask = 0;
+        mShift = 0;
+    }
 
-        while (mKeys[index].valid && index != endIndex) {
-            index++;
-        }
+    void grow(uint32_t newCapacity) {
+        auto oldControl = mControl;
+        auto oldKeys = mKeys;
+        auto oldValues = mValues;
+        auto oldCapacity = mCapacity;
+        auto size = mSize;
+
+        initialize(newCapacity);
+
+        for (uint32_t i = 0; i < oldCapacity; i++) {
+            if (oldControl[i] >= 0) {
+                auto hash = hashKey(oldKeys[i]);
+                auto index = findEmptyIndex(hash);
+
+                new (mKeys + index) K(std::move(oldKeys[i]));
+                new (mValues + index) T(std::move(oldValues[i]));
+                setControl(index, control(hash));
 
-        if (index >= mCapacity) {
-            index = 0;
-            while (mKeys[index].valid && index != endIndex) {
-                index++;
+                oldKeys[i].~K();
+                oldValues[i].~T();
             }
         }
 
-        return index;
+        mSize = size;
+
+        if (oldControl) {
+            mAllocator->deallocate(oldControl);
+            mAllocator->deallocate(oldKeys);
+            mAllocator->deallocate(oldValues);
+        }
     }
 
-    void rehash(uint32_t index) {
-        K& key = *(K*) &mKeys[index].key;
-        auto rehashedIndex = findEmptyKeyValue(key, index);
+    uint32_t insertNew(const K &key, const T &value) {
+        // Keep the load below 7/8 so every probe finds an empty slot quickly
+        // A moved from map has no table until its first insert
+        if ((mSize + 1) * 8 > mCapacity * 7) {
+            grow(mCapacity == 0 ? detail::GroupWidth : mCapacity * 2);
+        }
 
-        if (rehashedIndex != index) {
-            new (&mKeys[rehashedIndex].key) K(key);
-            mValues[rehashedIndex] = mValues[index];
+        auto hash = hashKey(key);
+        auto index = findEmptyIndex(hash);
 
-            mKeys[index].valid = false;
-            mValues[index].~T();
-            mKeys[rehashedIndex].valid = true;
-        }
-    }
+        new (mKeys + index) K(key);
+        new (mValues + index) T(value);
+        setControl(index, control(hash));
+
+        mSize++;
 
-    uint32_t hashKey(const K &key) const {
-        return XXHash32::hash(&key, sizeof(key), 283991);
+        return index;
     }
 
-    uint32_t findIndex(const K &key) const {
-        const uint32_t hash = hashKey(key);
-        auto index = hash % mMask;
+    uint32_t findEmptyIndex(uint64_t hash) const {
+        auto index = position(hash);
 
-        while (mKeys[index].valid) {
-            if (key == *reinterpret_cast<K *>(&mKeys[index].key)) {
-                return index;
+        while (true) {
+            auto empty = detail::ControlGroup(mControl + index).matchEmpty();
+            if (empty != 0) {
+                return (index + std::countr_zero(empty)) & mMask;
             }
-            index++;
+
+            index = (index + detail::GroupWidth) & mMask;
         }
+    }
 
-        if (index != mCapacity) {
+    template<typename Q>
+    ALWAYS_INLINE uint64_t hashKey(const Q &key) const {
+        return Hasher {}(key);
+    }
+
+    template<typename Q>
+    uint32_t findIndex(const Q &key) const {
+        // Also covers a moved from map, which has no table to probe
+        if (mSize == 0) {
             return mCapacity;
         }
 
-        index = 0;
-        while (mKeys[index].valid) {
-            if (key == *reinterpret_cast<K *>(&mKeys[index].key)) {
-                return index;
+        const auto hash = hashKey(key);
+        const auto h2 = control(hash);
+
+        auto start = position(hash);
+
+        while (true) {
+            detail::ControlGroup group(mControl + start);
+
+            for (auto matches = group.match(h2); matches != 0; matches &= matches - 1) {
+                auto index = (start + std::countr_zero(matches)) & mMask;
+                if (mKeys[index] == key) {
+                    return index;
+                }
             }
-            index++;
-        }
 
-        return mCapacity;
+            if (group.matchEmpty() != 0) {
+                return mCapacity;
+            }
+
+            start = (start + detail::GroupWidth) & mMask;
+        }
     }
-};
\ No newline at end of file
+};
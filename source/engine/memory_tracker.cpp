@@ -0,0 +1,151 @@
+#include "memory_tracker.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <vector>
+
+#ifdef AD_ALLOCATION_CALLSTACKS
+#include <execinfo.h>
+#endif
+
+std::string_view memoryTagName(MemoryTag tag) {
+    switch (tag) {
+        case MemoryTag::Untagged: return "Untagged";
+        case MemoryTag::Ecs: return "Ecs";
+        case MemoryTag::Gfx: return "Gfx";
+        case MemoryTag::Lua: return "Lua";
+        case MemoryTag::Terrain: return "Terrain";
+        case MemoryTag::Count: break;
+    }
+
+    return "Unknown";
+}
+
+void MemoryTracker::recordAllocation(MemoryTag tag, void *pointer, std::size_t size) {
+    auto &counters = mCounters[static_cast<std::size_t>(tag)];
+
+    auto live = counters.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    counters.liveCount.fetch_add(1, std::memory_order_relaxed);
+    counters.totalCount.fetch_add(1, std::memory_order_relaxed);
+
+    auto peak = counters.peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+
+#ifdef AD_ALLOCATION_CALLSTACKS
+    Callstack callstack { tag, size, 0, {} };
+    callstack.depth = backtrace(callstack.frames.data(), MaxCallstackDepth);
+
+    std::lock_guard lock(mCallstacksMutex);
+    mCallstacks[pointer] = callstack;
+#else
+    (void) pointer;
+#endif
+}
+
+void MemoryTracker::recordDeallocation(MemoryTag tag, void *pointer, std::size_t size) {
+    auto &counters = mCounters[static_cast<std::size_t>(tag)];
+
+    counters.liveBytes.fetch_sub(size, std::memory_order_relaxed);
+    counters.liveCount.fetch_sub(1, std::memory_order_relaxed);
+
+#ifdef AD_ALLOCATION_CALLSTACKS
+    std::lock_guard lock(mCallstacksMutex);
+    mCallstacks.erase(pointer);
+#else
+    (void) pointer;
+#endif
+}
+
+MemoryTagStats MemoryTracker::stats(MemoryTag tag) const {
+    const auto &counters = mCounters[static_cast<std::size_t>(tag)];
+
+    return {
+        counters.liveBytes.load(std::memory_order_relaxed),
+        counters.peakBytes.load(std::memory_order_relaxed),
+        counters.liveCount.load(std::memory_order_relaxed),
+        counters.totalCount.load(std::memory_order_relaxed),
+    };
+}
+
+void MemoryTracker::logStats() const {
+    for (std::size_t i = 0; i < MemoryTagCount; i++) {
+        auto tag = static_cast<MemoryTag>(i);
+        auto tagStats = stats(tag);
+
+        Logger::info("Memory {}: {} bytes live in {} allocations, peak {} bytes, {} allocations total",
+                     memoryTagName(tag), tagStats.liveBytes, tagStats.liveCount, tagStats.peakBytes, tagStats.totalCount);
+    }
+}
+
+void MemoryTracker::logLiveAllocations(MemoryTag tag, std::size_t maxEntries) const {
+#ifdef AD_ALLOCATION_CALLSTACKS
+    std::vector<std::pair<void*, Callstack>> allocations;
+
+    {
+        std::lock_guard lock(mCallstacksMutex);
+        for (const auto &[pointer, callstack] : mCallstacks) {
+            if (callstack.tag == tag) {
+                allocations.emplace_back(pointer, callstack);
+            }
+        }
+    }
+
+    std::sort(allocations.begin(), allocations.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.second.size > rhs.second.size;
+    });
+
+    allocations.resize(std::min(allocations.size(), maxEntries));
+
+    for (const auto &[pointer, callstack] : allocations) {
+        Logger::info("Memory {}: {} bytes live", memoryTagName(tag), callstack.size);
+
+        auto symbols = backtrace_symbols(callstack.frames.data(), callstack.depth);
+        for (int i = 0; i < callstack.depth; i++) {
+            Logger::info("    {}", std::string { symbols[i] });
+        }
+
+        free(symbols);
+    }
+#else
+    (void) tag;
+    (void) maxEntries;
+#endif
+}
+
+void *TaggedAllocator::allocate(std::size_t size, std::size_t alignment) {
+    // Keep the payload aligned behind the header
+    auto offset = std::max(sizeof(Header), alignment);
+
+    std::byte *block;
+    try {
+        block = static_cast<std::byte*>(mBacking.allocate(size + offset, std::max(alignment, alignof(Header))));
+    } catch (const std::bad_alloc &) {
+        Logger::error("Out of memory allocating {} bytes for {}", size, memoryTagName(mTag));
+        MemoryTracker::instance().logStats();
+        throw;
+    }
+
+    auto payload = block + offset;
+
+    auto header = reinterpret_cast<Header*>(payload - sizeof(Header));
+    header->size = size;
+    header->offset = offset;
+
+    MemoryTracker::instance().recordAllocation(mTag, payload, size);
+
+    return payload;
+}
+
+void TaggedAllocator::deallocate(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+
+    auto payload = static_cast<std::byte*>(pointer);
+    auto header = reinterpret_cast<Header*>(payload - sizeof(Header));
+
+    MemoryTracker::instance().recordDeallocation(mTag, pointer, header->size);
+
+    mBacking.deallocate(payload - header->offset);
+}
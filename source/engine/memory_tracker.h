@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include "allocator.h"
+#include "platform/gcc.h"
+
+enum class MemoryTag : uint32_t {
+    Untagged,
+    Ecs,
+    Gfx,
+    Lua,
+    Terrain,
+    Count,
+};
+
+constexpr std::size_t MemoryTagCount = static_cast<std::size_t>(MemoryTag::Count);
+
+std::string_view memoryTagName(MemoryTag tag);
+
+struct MemoryTagStats {
+    std::size_t liveBytes { 0 };
+    std::size_t peakBytes { 0 };
+    std::size_t liveCount { 0 };
+    std::size_t totalCount { 0 };
+};
+
+// Collects live, peak and count statistics per memory tag. The counters are atomic so tagged allocators can be used
+// from any thread. Builds with AD_ALLOCATION_CALLSTACKS also keep the callstack of every live tagged allocation.
+class MemoryTracker {
+public:
+    static MemoryTracker& instance() {
+        static MemoryTracker sInstance;
+        return sInstance;
+    }
+
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+    void recordAllocation(MemoryTag tag, void *pointer, std::size_t size);
+    void recordDeallocation(MemoryTag tag, void *pointer, std::size_t size);
+
+    [[nodiscard]] MemoryTagStats stats(MemoryTag tag) const;
+
+    void logStats() const;
+
+    // Logs the callstacks of the largest live allocations of the tag, does nothing without AD_ALLOCATION_CALLSTACKS
+    void logLiveAllocations(MemoryTag tag, std::size_t maxEntries = 10) const;
+private:
+    MemoryTracker() = default;
+
+    struct Counters {
+        std::atomic<std::size_t> liveBytes { 0 };
+        std::atomic<std::size_t> peakBytes { 0 };
+        std::atomic<std::size_t> liveCount { 0 };
+        std::atomic<std::size_t> totalCount { 0 };
+    };
+
+    std::array<Counters, MemoryTagCount> mCounters;
+
+#ifdef AD_ALLOCATION_CALLSTACKS
+    static constexpr int MaxCallstackDepth = 16;
+
+    struct Callstack {
+        MemoryTag tag;
+        std::size_t size;
+        int depth;
+        std::array<void*, MaxCallstackDepth> frames;
+    };
+
+    mutable std::mutex mCallstacksMutex;
+    std::unordered_map<void*, Callstack> mCallstacks;
+#endif
+};
+
+// Forwards to a backing allocator and attributes every allocation to a memory tag. A small header in front of each
+// allocation remembers its size for the statistics.
+class TaggedAllocator : public Allocator {
+public:
+    TaggedAllocator(Allocator &backing, MemoryTag tag)
+        : Allocator(0)
+        , mBacking(backing)
+        , mTag(tag)
+    {
+    }
+
+    TaggedAllocator(const TaggedAllocator&) = delete;
+    TaggedAllocator& operator=(const TaggedAllocator&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment) override;
+    void deallocate(void* pointer) override;
+
+    [[nodiscard]] constexpr ALWAYS_INLINE MemoryTag tag() const { return mTag; }
+    [[nodiscard]] MemoryTagStats stats() const { return MemoryTracker::instance().stats(mTag); }
+private:
+    struct Header {
+        std::size_t size;
+        std::size_t offset;
+    };
+
+    Allocator &mBacking;
+    MemoryTag mTag;
+};
@@ -22,6 +22,7 @@ public:
     [[nodiscard]] constexpr ALWAYS_INLINE Hash64 hash() const { return mHash; }
 
     inline auto operator==(const Path &rhs) const { return mHash == rhs.mHash; }
+    inline auto operator==(const Hash64 &rhs) const { return mHash == rhs; }
 
 private:
     std::string mValue {};
@@ -31,6 +32,6 @@ private:
 template<>
 struct std::hash<Path> {
     auto operator()(const Path &path) const -> size_t {
-        return hash<uint64_t>()(path.hash().value());
+        return path.hash().value();
     }
 };
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "allocator.h"
+#include "platform/gcc.h"
+
+// Hands out fixed size slots for objects of type T. Slots are carved from slabs taken from a backing allocator and
+// freed slots are kept on an intrusive free list, so allocate and deallocate are O(1) and objects of one type stay
+// packed together. The slot size can be raised to also fit types derived from T.
+template<typename T>
+class PoolAllocator : public Allocator {
+public:
+    explicit PoolAllocator(Allocator &backing, std::size_t slotsPerSlab = 64, std::size_t slotSize = sizeof(T),
+                           std::size_t slotAlignment = alignof(T))
+        : Allocator(0)
+        , mBacking(backing)
+        , mSlotAlignment(std::max(slotAlignment, alignof(FreeSlot)))
+        , mSlotsPerSlab(slotsPerSlab)
+    {
+        mSlotSize = std::max(slotSize, sizeof(FreeSlot));
+        mSlotSize += (mSlotAlignment - mSlotSize % mSlotAlignment) % mSlotAlignment;
+    }
+
+    // Objects still alive in the pool are not destructed, their memory is released with the slabs
+    ~PoolAllocator() {
+        for (auto slab : mSlabs) {
+            mBacking.deallocate(slab);
+        }
+    }
+
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment) override {
+        if (size > mSlotSize || alignment > mSlotAlignment) {
+            throw std::bad_alloc();
+        }
+
+        if (mFreeList == nullptr) {
+            addSlab();
+        }
+
+        auto slot = mFreeList;
+        mFreeList = slot->next;
+
+        mUsed += mSlotSize;
+        mPeak = std::max(mPeak, mUsed);
+
+        return slot;
+    }
+
+    void deallocate(void *pointer) override {
+        if (pointer == nullptr) {
+            return;
+        }
+
+        auto slot = static_cast<FreeSlot*>(pointer);
+        slot->next = mFreeList;
+        mFreeList = slot;
+
+        mUsed -= mSlotSize;
+    }
+
+    template<typename U = T, typename ...Args>
+    U* create(Args&& ...args) {
+        static_assert(std::is_base_of_v<T, U>, "Pool only holds T and types derived from T");
+
+        auto memory = allocate(sizeof(U), alignof(U));
+
+        try {
+            return new (memory) U(std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(memory);
+            throw;
+        }
+    }
+
+    void destroy(T *object) {
+        if (object == nullptr) {
+            return;
+        }
+
+        object->~T();
+        deallocate(object);
+    }
+
+    [[nodiscard]] constexpr ALWAYS_INLINE std::size_t slotSize() const { return mSlotSize; }
+private:
+    struct FreeSlot {
+        FreeSlot *next;
+    };
+
+    Allocator &mBacking;
+
+    std::size_t mSlotSize;
+    std::size_t mSlotAlignment;
+    std::size_t mSlotsPerSlab;
+
+    FreeSlot *mFreeList { nullptr };
+    std::vector<void*> mSlabs;
+
+    void addSlab() {
+        auto slab = static_cast<std::byte*>(mBacking.allocate(mSlotSize * mSlotsPerSlab, mSlotAlignment));
+        mSlabs.push_back(slab);
+
+        // Thread the slots in address order so fresh allocations walk the slab front to back
+        for (std::size_t i = mSlotsPerSlab; i > 0; i--) {
+            auto slot = reinterpret_cast<FreeSlot*>(slab + (i - 1) * mSlotSize);
+            slot->next = mFreeList;
+            mFreeList = slot;
+        }
+
+        mTotalSize += mSlotSize * mSlotsPerSlab;
+    }
+};
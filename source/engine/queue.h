@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include "allocator.h"
+#include "platform/gcc.h"
+
+namespace detail {
+    constexpr std::size_t CacheLineSize = 64;
+
+    inline std::size_t queueCapacity(std::size_t capacity) {
+        if (capacity < 2) {
+            throw std::runtime_error("Queue capacity must be at least 2");
+        }
+
+        return std::bit_ceil(capacity);
+    }
+}
+
+// Bounded ring buffer for exactly one producer and one consumer thread. Each side caches the other side's index so
+// it only touches the shared cache line when the ring looks full or empty.
+template<typename T>
+class SpscQueue {
+public:
+    SpscQueue(Allocator &allocator, std::size_t capacity)
+        : mAllocator(allocator)
+        , mCapacity(detail::queueCapacity(capacity))
+        , mMask(mCapacity - 1)
+    {
+        mSlots = static_cast<T*>(mAllocator.allocate(sizeof(T) * mCapacity, alignof(T)));
+    }
+
+    ~SpscQueue() {
+        while (pop()) {
+        }
+
+        mAllocator.deallocate(mSlots);
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Returns false when the queue is full
+    template<typename ...Args>
+    bool push(Args&& ...args) {
+        auto tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mCachedHead == mCapacity) {
+            mCachedHead = mHead.load(std::memory_order_acquire);
+            if (tail - mCachedHead == mCapacity) {
+                return false;
+            }
+        }
+
+        new (mSlots + (tail & mMask)) T(std::forward<Args>(args)...);
+        mTail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    std::optional<T> pop() {
+        auto head = mHead.load(std::memory_order_relaxed);
+        if (head == mCachedTail) {
+            mCachedTail = mTail.load(std::memory_order_acquire);
+            if (head == mCachedTail) {
+                return std::nullopt;
+            }
+        }
+
+        auto &slot = mSlots[head & mMask];
+        std::optional<T> value { std::move(slot) };
+        slot.~T();
+
+        mHead.store(head + 1, std::memory_order_release);
+
+        return value;
+    }
+
+    // Only exact when called from the producer or consumer thread while the other side is idle
+    [[nodiscard]] std::size_t size() const {
+        return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] constexpr ALWAYS_INLINE std::size_t capacity() const { return mCapacity; }
+private:
+    Allocator &mAllocator;
+    std::size_t mCapacity;
+    std::size_t mMask;
+    T *mSlots;
+
+    alignas(detail::CacheLineSize) std::atomic<std::size_t> mHead { 0 };
+    std::size_t mCachedTail { 0 };
+
+    alignas(detail::CacheLineSize) std::atomic<std::size_t> mTail { 0 };
+    std::size_t mCachedHead { 0 };
+};
+
+// Bounded queue for any number of producers and consumers, after Dmitry Vyukov's design. Every slot carries a
+// sequence number telling whether it is ready to be written or read for the current lap, so producers and consumers
+// only contend on their own position counter with a single compare exchange.
+template<typename T>
+class MpmcQueue {
+public:
+    MpmcQueue(Allocator &allocator, std::size_t capacity)
+        : mAllocator(allocator)
+        , mCapacity(detail::queueCapacity(capacity))
+        , mMask(mCapacity - 1)
+    {
+        mSlots = static_cast<Slot*>(mAllocator.allocate(sizeof(Slot) * mCapacity, alignof(Slot)));
+        for (std::size_t i = 0; i < mCapacity; i++) {
+            new (&mSlots[i].sequence) std::atomic<std::size_t>(i);
+        }
+    }
+
+    ~MpmcQueue() {
+        while (pop()) {
+        }
+
+        mAllocator.deallocate(mSlots);
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // Returns false when the queue is full
+    template<typename ...Args>
+    bool push(Args&& ...args) {
+        auto position = mEnqueuePosition.load(std::memory_order_relaxed);
+        Slot *slot;
+
+        while (true) {
+            slot = &mSlots[position & mMask];
+            auto sequence = slot->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+            if (difference == 0) {
+                if (mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = mEnqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (slot->value()) T(std::forward<Args>(args)...);
+        slot->sequence.store(position + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    std::optional<T> pop() {
+        auto position = mDequeuePosition.load(std::memory_order_relaxed);
+        Slot *slot;
+
+        while (true) {
+            slot = &mSlots[position & mMask];
+            auto sequence = slot->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+            if (difference == 0) {
+                if (mDequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return std::nullopt;
+            } else {
+                position = mDequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        auto value = slot->value();
+        std::optional<T> result { std::move(*value) };
+        value->~T();
+
+        // Hand the slot to the producers of the next lap
+        slot->sequence.store(position + mMask + 1, std::memory_order_release);
+
+        return result;
+    }
+
+    [[nodiscard]] constexpr ALWAYS_INLINE std::size_t capacity() const { return mCapacity; }
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        alignas(T) std::byte storage[sizeof(T)];
+
+        ALWAYS_INLINE T* value() { return reinterpret_cast<T*>(storage); }
+    };
+
+    Allocator &mAllocator;
+    std::size_t mCapacity;
+    std::size_t mMask;
+    Slot *mSlots;
+
+    alignas(detail::CacheLineSize) std::atomic<std::size_t> mEnqueuePosition { 0 };
+    alignas(detail::CacheLineSize) std::atomic<std::size_t> mDequeuePosition { 0 };
+};
@@ -1,132 +1,313 @@
 #pragma once
 
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include "allocator.h"
 #include "platform/gcc.h"
 
+// Types that can be moved to a new address with memcpy, without running a move constructor and destructor.
+// Specialize for types that own memory but never point into themselves.
 template<typename T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+namespace detail {
+    template<typename T, std::size_t N>
+    struct InlineStorage {
+        [[nodiscard]] ALWAYS_INLINE T* data() { return reinterpret_cast<T*>(bytes); }
+
+        alignas(T) std::byte bytes[N * sizeof(T)];
+    };
+
+    template<typename T>
+    struct InlineStorage<T, 0> {
+        [[nodiscard]] ALWAYS_INLINE T* data() { return nullptr; }
+    };
+}
+
+// Growable array on an Allocator. The first InlineCapacity items live inside the vector itself, the heap is only
+// touched once it grows past them.
+template<typename T, std::size_t InlineCapacity = 0>
 class Vector {
 public:
-   explicit Vector(Allocator &allocator, const std::size_t initialCapacity = 0)
-      : mAllocator(allocator)
-      , mCapacity(initialCapacity)
-   {
-      if (mCapacity > 0) {
-         mData = static_cast<T*>(mAllocator.allocate(mCapacity * sizeof(T), alignof(T)));
-      }
-   }
-
-   Vector(Vector &&rhs) noexcept
-      : mAllocator(rhs.mAllocator)
-      , mCapacity(0)
-   {
-       auto i = rhs.mCapacity;
-       rhs.mCapacity = mCapacity;
-       mCapacity = i;
-
-       i = mSize;
-       mSize = rhs.mSize;
-       rhs.mSize = i;
-
-       T* p = rhs.mData;
-       rhs.mData = mData;
-       mData = p;
-   }
-
-   ~Vector() {
-       if (!mData) {
-           return;
-       }
-
-       destructItems();
-       mAllocator.deallocate(mData);
-   }
-
-   Vector(const Vector &rhs) = delete;
-   Vector& operator=(const Vector &rhs) = delete;
-
-   constexpr ALWAYS_INLINE T* begin() const { return mData; }
-   constexpr ALWAYS_INLINE T* end() const {
-       if (mData == nullptr) {
-           return nullptr;
-       }
-
-       return mData + mSize;
-   }
-
-   constexpr ALWAYS_INLINE T* data() {
-       return mData;
-   }
-
-   constexpr ALWAYS_INLINE T& operator[](const std::size_t index) const {
-       return mData[index];
-   }
-
-   [[nodiscard]] constexpr ALWAYS_INLINE std::size_t size() const { return mSize; }
-
-   void push(T&& value) {
-       auto size = mSize;
-       if (size == mCapacity) {
-           expand();
-       }
-
-       new (mData + size) T(std::move(value));
-
-       size++;
-       mSize = size;
-   }
-
-   void push(const T& value) {
-       auto size = mSize;
-       if (size == mCapacity) {
-           expand();
-       }
-
-       new (mData + size) T(value);
-
-       size++;
-       mSize = size;
-   }
-
-   void reserve(std::size_t capacity) {
-        if (capacity > mCapacity) {
-            auto newCapacity = capacity;
-            auto newSize = mSize;
-            auto newData = static_cast<T*>(mAllocator.allocate(newCapacity * sizeof(T), alignof(T)));
-            if (mData != nullptr) {
-                for (auto i = 0; i < mSize; ++i) {
-                    new (newData + i) T(std::move(mData[i]));
-                }
-
-                mAllocator.deallocate(mData);
+    explicit Vector(Allocator &allocator, const std::size_t initialCapacity = 0)
+        : mAllocator(allocator)
+    {
+        mData = mInline.data();
+        mCapacity = InlineCapacity;
+
+        reserve(initialCapacity);
+    }
+
+    Vector(Vector &&rhs) noexcept
+        : mAllocator(rhs.mAllocator)
+    {
+        mData = mInline.data();
+        mCapacity = InlineCapacity;
+
+        if (rhs.isInline()) {
+            relocate(mData, rhs.mData, rhs.mSize);
+        } else {
+            mData = rhs.mData;
+            mCapacity = rhs.mCapacity;
+        }
+
+        mSize = rhs.mSize;
+
+        rhs.mData = rhs.mInline.data();
+        rhs.mCapacity = InlineCapacity;
+        rhs.mSize = 0;
+    }
+
+    ~Vector() {
+        destructItems(0, mSize);
+        freeStorage();
+    }
+
+    Vector(const Vector &rhs) = delete;
+    Vector& operator=(const Vector &rhs) = delete;
+
+    constexpr ALWAYS_INLINE T* begin() const { return mData; }
+    constexpr ALWAYS_INLINE T* end() const {
+        if (mData == nullptr) {
+            return nullptr;
+        }
+
+        return mData + mSize;
+    }
+
+    constexpr ALWAYS_INLINE T* data() {
+        return mData;
+    }
+
+    constexpr ALWAYS_INLINE T& operator[](const std::size_t index) const {
+        return mData[index];
+    }
+
+    [[nodiscard]] constexpr ALWAYS_INLINE std::size_t size() const { return mSize; }
+    [[nodiscard]] constexpr ALWAYS_INLINE std::size_t capacity() const { return mCapacity; }
+    [[nodiscard]] constexpr ALWAYS_INLINE bool empty() const { return mSize == 0; }
+
+    void push(T&& value) {
+        emplace(std::move(value));
+    }
+
+    void push(const T& value) {
+        emplace(value);
+    }
+
+    template<typename ...Args>
+    T& emplace(Args&& ...args) {
+        if (mSize == mCapacity) {
+            expand(mSize + 1);
+        }
+
+        auto item = new (mData + mSize) T(std::forward<Args>(args)...);
+        mSize++;
+
+        return *item;
+    }
+
+    void append(const T *values, std::size_t count) {
+        if (values >= mData && values < mData + mSize) {
+            auto offset = values - mData;
+            reserveForGrowth(mSize + count);
+            values = mData + offset;
+        }
+
+        reserveForGrowth(mSize + count);
+        copyConstruct(mData + mSize, values, count);
+        mSize += count;
+    }
+
+    template<typename It>
+    void append(It first, It last) {
+        if constexpr (std::is_pointer_v<It>) {
+            append(first, static_cast<std::size_t>(last - first));
+        } else {
+            reserveForGrowth(mSize + std::distance(first, last));
+            for (; first != last; ++first) {
+                new (mData + mSize) T(*first);
+                mSize++;
             }
-            mData = newData;
-            mCapacity = newCapacity;
-            mSize = newSize;
         }
-   }
+    }
+
+    void insert(std::size_t index, const T *values, std::size_t count) {
+        if (count == 0) {
+            return;
+        }
+
+        // Copy first so inserting a range of this vector into itself stays valid while items are shifted
+        if (values >= mData && values < mData + mSize) {
+            Vector copy(mAllocator);
+            copy.append(values, count);
+            insert(index, copy.data(), count);
+            return;
+        }
 
-   void clear() {
-       destructItems();
-       mSize = 0;
-   }
+        reserveForGrowth(mSize + count);
+
+        relocate(mData + index + count, mData + index, mSize - index);
+        copyConstruct(mData + index, values, count);
+        mSize += count;
+    }
+
+    void insert(std::size_t index, const T &value) {
+        insert(index, &value, 1);
+    }
+
+    void erase(std::size_t from, std::size_t to) {
+        if (from >= to) {
+            return;
+        }
+
+        destructItems(from, to);
+        relocate(mData + from, mData + to, mSize - to);
+        mSize -= to - from;
+    }
+
+    void erase(std::size_t index) {
+        erase(index, index + 1);
+    }
+
+    void reserve(std::size_t capacity) {
+        if (capacity <= mCapacity) {
+            return;
+        }
+
+        auto newData = static_cast<T*>(mAllocator.allocate(capacity * sizeof(T), alignof(T)));
+        relocate(newData, mData, mSize);
+        freeStorage();
+
+        mData = newData;
+        mCapacity = capacity;
+    }
+
+    void pop() {
+        mSize--;
+        mData[mSize].~T();
+    }
+
+    constexpr ALWAYS_INLINE T& back() const {
+        return mData[mSize - 1];
+    }
+
+    void resize(std::size_t size) {
+        if (size < mSize) {
+            destructItems(size, mSize);
+            mSize = size;
+            return;
+        }
+
+        reserveForGrowth(size);
+        if constexpr (std::is_trivially_default_constructible_v<T>) {
+            std::memset(static_cast<void*>(mData + mSize), 0, (size - mSize) * sizeof(T));
+        } else {
+            for (auto i = mSize; i < size; i++) {
+                new (mData + i) T();
+            }
+        }
+        mSize = size;
+    }
+
+    void resize(std::size_t size, const T& value) {
+        if (size < mSize) {
+            destructItems(size, mSize);
+            mSize = size;
+            return;
+        }
+
+        reserveForGrowth(size);
+        for (auto i = mSize; i < size; i++) {
+            new (mData + i) T(value);
+        }
+        mSize = size;
+    }
+
+    void clear() {
+        destructItems(0, mSize);
+        mSize = 0;
+    }
+
+    // Destructs the items and hands the storage back, needed by vectors on a frame arena that outlive the frame
+    void reset() {
+        destructItems(0, mSize);
+        freeStorage();
+
+        mData = mInline.data();
+        mCapacity = InlineCapacity;
+        mSize = 0;
+    }
 
 private:
     Allocator &mAllocator;
     T *mData { nullptr };
-    std::size_t mCapacity;
+    std::size_t mCapacity { 0 };
     std::size_t mSize { 0 };
+    [[no_unique_address]] detail::InlineStorage<T, InlineCapacity> mInline;
+
+    [[nodiscard]] ALWAYS_INLINE bool isInline() {
+        return InlineCapacity > 0 && mData == mInline.data();
+    }
+
+    void freeStorage() {
+        if (mData != nullptr && !isInline()) {
+            mAllocator.deallocate(mData);
+        }
+    }
+
+    void destructItems(std::size_t from, std::size_t to) {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (auto i = from; i < to; i++) {
+                mData[i].~T();
+            }
+        }
+    }
+
+    // Moves count items from source to a possibly overlapping destination, the source items are left destructed
+    static void relocate(T *destination, T *source, std::size_t count) {
+        if (count == 0 || destination == source) {
+            return;
+        }
+
+        if constexpr (IsTriviallyRelocatable<T>::value) {
+            std::memmove(static_cast<void*>(destination), static_cast<const void*>(source), count * sizeof(T));
+        } else if (destination < source) {
+            for (std::size_t i = 0; i < count; i++) {
+                new (destination + i) T(std::move(source[i]));
+                source[i].~T();
+            }
+        } else {
+            for (auto i = count; i > 0; i--) {
+                new (destination + i - 1) T(std::move(source[i - 1]));
+                source[i - 1].~T();
+            }
+        }
+    }
 
-    void destructItems(int from = 0, int to = -1) {
-        if (to == -1) {
-            to = mSize;
+    static void copyConstruct(T *destination, const T *source, std::size_t count) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (count > 0) {
+                std::memcpy(static_cast<void*>(destination), static_cast<const void*>(source), count * sizeof(T));
+            }
+        } else {
+            for (std::size_t i = 0; i < count; i++) {
+                new (destination + i) T(source[i]);
+            }
         }
+    }
 
-        for (auto i = from; i < to; i++) {
-            mData[i].~T();
+    void reserveForGrowth(std::size_t size) {
+        if (size > mCapacity) {
+            expand(size);
         }
     }
 
-    void expand() {
-        reserve(mCapacity < 4 ? 4 : mCapacity * 1.5);
+    void expand(std::size_t minimumCapacity) {
+        auto capacity = mCapacity < 4 ? 4 : mCapacity + mCapacity / 2;
+        reserve(capacity < minimumCapacity ? minimumCapacity : capacity);
     }
-};
\ No newline at end of file
+};
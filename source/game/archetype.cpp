@@ -0,0 +1,190 @@
+#include "archetype.h"
+
+namespace game {
+    inline constexpr std::size_t alignOffset(std::size_t offset, std::size_t alignment) {
+        auto remainder = offset % alignment;
+        return remainder == 0 ? offset : offset + alignment - remainder;
+    }
+
+    Archetype::Archetype(const Signature &signature, Allocator &allocator)
+        : mAllocator(allocator)
+        , mSignature(signature)
+    {
+        for (ComponentType type = 0; type < MaxComponents; type++) {
+            if (mSignature.test(type)) {
+                const auto &staticData = ComponentRegistry::componentStaticData(type);
+
+                mColumnIndices[type] = static_cast<uint32_t>(mColumns.size());
+                mColumns.push_back({ &staticData, 0, static_cast<uint32_t>(staticData.size) });
+            }
+        }
+
+        calculateLayout();
+    }
+
+    Archetype::~Archetype() {
+        for (auto &chunk : mChunks) {
+            for (auto &column : mColumns) {
+                for (uint32_t row = 0; row < chunk.count; row++) {
+                    column.staticData->destruct(chunk.data + column.offset + row * column.size);
+                }
+            }
+
+            mAllocator.deallocate(chunk.data);
+        }
+    }
+
+    void Archetype::calculateLayout() {
+        std::size_t rowSize = sizeof(Object);
+        for (const auto &column : mColumns) {
+            rowSize += column.size;
+        }
+
+        // Start from the unpadded estimate and shrink until all aligned columns fit in the chunk
+        auto capacity = static_cast<uint32_t>(ArchetypeChunkSize / rowSize);
+
+        while (capacity > 0) {
+            std::size_t offset = sizeof(Object) * capacity;
+
+            for (auto &column : mColumns) {
+                offset = alignOffset(offset, column.staticData->alignment);
+                column.offset = static_cast<uint32_t>(offset);
+                offset += column.size * capacity;
+            }
+
+            if (offset <= ArchetypeChunkSize) {
+                break;
+            }
+
+            capacity--;
+        }
+
+        if (capacity == 0) {
+            throw std::runtime_error("Archetype row doesn't fit in a chunk");
+        }
+
+        mChunkCapacity = capacity;
+    }
+
+    Archetype::Row Archetype::allocateRow(Object object) {
+        if (mChunks.empty() || mChunks.back().count == mChunkCapacity) {
+            auto data = static_cast<std::byte*>(mAllocator.allocate(ArchetypeChunkSize, alignof(std::max_align_t)));
+            mChunks.push_back({ data, 0 });
+        }
+
+        auto chunkIndex = static_cast<uint32_t>(mChunks.size() - 1);
+        auto &chunk = mChunks.back();
+
+        Row row { chunkIndex, chunk.count++ };
+        new (objects(chunkIndex) + row.row) Object(object);
+
+        mSize++;
+
+        return row;
+    }
+
+    std::optional<Object> Archetype::removeRow(Row row) {
+        auto &chunk = mChunks[row.chunk];
+        auto &lastChunk = mChunks.back();
+        auto lastRow = lastChunk.count - 1;
+
+        std::optional<Object> movedObject;
+        bool isLast = &chunk == &lastChunk && row.row == lastRow;
+
+        for (const auto &column : mColumns) {
+            auto destination = chunk.data + column.offset + row.row * column.size;
+            column.staticData->destruct(destination);
+
+            if (!isLast) {
+                auto source = lastChunk.data + column.offset + lastRow * column.size;
+                column.staticData->moveConstruct(destination, source);
+                column.staticData->destruct(source);
+            }
+        }
+
+        if (!isLast) {
+            auto lastObject = objects(mChunks.size() - 1)[lastRow];
+            objects(row.chunk)[row.row] = lastObject;
+            movedObject = lastObject;
+        }
+
+        lastChunk.count--;
+        mSize--;
+
+        if (lastChunk.count == 0) {
+            mAllocator.deallocate(lastChunk.data);
+            mChunks.pop_back();
+        }
+
+        return movedObject;
+    }
+
+    void ArchetypeStorage::entityDestroyed(Object object) {
+        if (object.id() >= mLocations.size()) {
+            return;
+        }
+
+        auto &location = mLocations[object.id()];
+        if (location.archetype == nullptr) {
+            return;
+        }
+
+        moveObject(object, location, Signature {});
+    }
+
+    ArchetypeStorage::Location& ArchetypeStorage::locationOf(Object object) {
+        if (object.id() >= mLocations.size()) {
+            mLocations.resize(object.id() + 1);
+        }
+
+        return mLocations[object.id()];
+    }
+
+    Archetype* ArchetypeStorage::getArchetype(const Signature &signature) {
+        auto it = mArchetypes.find(signature);
+        if (it != mArchetypes.end()) {
+            return it->second.get();
+        }
+
+        auto archetype = std::make_unique<Archetype>(signature, mChunkPool);
+        auto result = archetype.get();
+
+        mArchetypes.insert({ signature, std::move(archetype) });
+        mArchetypeList.push_back(result);
+
+        return result;
+    }
+
+    Archetype::Row ArchetypeStorage::moveObject(Object object, Location &location, const Signature &signature) {
+        auto source = location.archetype;
+        auto sourceRow = location.row;
+
+        Archetype *destination = signature.none() ? nullptr : getArchetype(signature);
+        Archetype::Row destinationRow { 0, 0 };
+
+        if (destination) {
+            destinationRow = destination->allocateRow(object);
+
+            if (source) {
+                auto shared = source->signature() & signature;
+                for (ComponentType type = 0; type < MaxComponents; type++) {
+                    if (shared.test(type)) {
+                        const auto &staticData = ComponentRegistry::componentStaticData(type);
+                        staticData.moveConstruct(destination->component(destinationRow, type), source->component(sourceRow, type));
+                    }
+                }
+            }
+        }
+
+        if (source) {
+            if (auto movedObject = source->removeRow(sourceRow); movedObject.has_value()) {
+                mLocations[movedObject->id()].row = sourceRow;
+            }
+        }
+
+        location.archetype = destination;
+        location.row = destinationRow;
+
+        return destinationRow;
+    }
+}
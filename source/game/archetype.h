@@ -0,0 +1,196 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include "object.h"
+#include "component_registry.h"
+#include "engine/pool_allocator.h"
+
+namespace game {
+    constexpr std::size_t ArchetypeChunkSize = 16 * 1024;
+    constexpr std::size_t ArchetypeChunksPerSlab = 4;
+
+    struct alignas(std::max_align_t) ArchetypeChunk {
+        std::byte data[ArchetypeChunkSize];
+    };
+
+    // All objects sharing one signature. Objects are stored in fixed size chunks, every chunk holds an object column
+    // followed by one tightly packed column per component type (SoA), so iterating a chunk walks linear memory.
+    class Archetype {
+    public:
+        struct Row {
+            uint32_t chunk;
+            uint32_t row;
+        };
+
+        Archetype(const Signature &signature, Allocator &allocator);
+        ~Archetype();
+
+        Archetype(const Archetype &) = delete;
+        Archetype& operator=(const Archetype &) = delete;
+
+        // Reserves a row for the object, the component slots of the row are left uninitialized
+        Row allocateRow(Object object);
+
+        // Destructs the components in the row and fills the hole with the last row of the archetype.
+        // Returns the object that was moved into the row, if any.
+        std::optional<Object> removeRow(Row row);
+
+        [[nodiscard]] constexpr ALWAYS_INLINE const Signature& signature() const { return mSignature; }
+        [[nodiscard]] constexpr ALWAYS_INLINE uint32_t chunkCapacity() const { return mChunkCapacity; }
+        [[nodiscard]] constexpr ALWAYS_INLINE std::size_t size() const { return mSize; }
+        [[nodiscard]] ALWAYS_INLINE std::size_t chunkCount() const { return mChunks.size(); }
+        [[nodiscard]] ALWAYS_INLINE uint32_t chunkSize(std::size_t chunk) const { return mChunks[chunk].count; }
+
+        [[nodiscard]] ALWAYS_INLINE Object* objects(std::size_t chunk) const {
+            return reinterpret_cast<Object*>(mChunks[chunk].data);
+        }
+
+        [[nodiscard]] ALWAYS_INLINE bool contains(Row row, Object object) const {
+            return objects(row.chunk)[row.row] == object;
+        }
+
+        [[nodiscard]] ALWAYS_INLINE void* column(std::size_t chunk, ComponentType type) const {
+            return mChunks[chunk].data + mColumns[mColumnIndices[type]].offset;
+        }
+
+        template<typename T>
+        [[nodiscard]] ALWAYS_INLINE T* column(std::size_t chunk) const {
+            return static_cast<T*>(column(chunk, T::type()));
+        }
+
+        [[nodiscard]] ALWAYS_INLINE void* component(Row row, ComponentType type) const {
+            const auto &column = mColumns[mColumnIndices[type]];
+            return mChunks[row.chunk].data + column.offset + row.row * column.size;
+        }
+    private:
+        struct Chunk {
+            std::byte *data;
+            uint32_t count;
+        };
+
+        struct Column {
+            const IComponentArrayStaticData *staticData;
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        Allocator &mAllocator;
+        Signature mSignature;
+
+        std::vector<Column> mColumns;
+        std::array<uint32_t, MaxComponents> mColumnIndices {};
+
+        std::vector<Chunk> mChunks;
+        uint32_t mChunkCapacity { 0 };
+        std::size_t mSize { 0 };
+
+        void calculateLayout();
+    };
+
+    // Opt-in alternative to the per type component arrays, objects move between archetypes when their signature
+    // changes.
+    class ArchetypeStorage {
+    public:
+        explicit ArchetypeStorage(Allocator &allocator)
+            : mChunkPool(allocator, ArchetypeChunksPerSlab)
+        {
+        }
+
+        ArchetypeStorage(const ArchetypeStorage &) = delete;
+        ArchetypeStorage& operator=(const ArchetypeStorage &) = delete;
+
+        template<typename T>
+        void addComponent(Object object, T component) {
+            auto &location = locationOf(object);
+            auto signature = location.archetype ? location.archetype->signature() : Signature {};
+
+            if (signature.test(T::type())) {
+                throw std::runtime_error("Component already exists");
+            }
+
+            signature.set(T::type(), true);
+
+            auto row = moveObject(object, location, signature);
+            new (location.archetype->component(row, T::type())) T(std::move(component));
+        }
+
+        template<typename T>
+        void removeComponent(Object object) {
+            auto &location = locationOf(object);
+            if (!location.archetype || !location.archetype->signature().test(T::type()) || !location.archetype->contains(location.row, object)) {
+                throw std::runtime_error("Component does not exist");
+            }
+
+            auto signature = location.archetype->signature();
+            signature.set(T::type(), false);
+
+            moveObject(object, location, signature);
+        }
+
+        template<typename T>
+        T& getComponent(Object object) {
+            auto component = getComponentPtr<T>(object);
+            if (component == nullptr) {
+                throw std::runtime_error("Component does not exist");
+            }
+
+            return *component;
+        }
+
+        template<typename T>
+        T* getComponentPtr(Object object) {
+            if (object.id() >= mLocations.size()) {
+                return nullptr;
+            }
+
+            const auto &location = mLocations[object.id()];
+            if (!location.archetype || !location.archetype->signature().test(T::type()) || !location.archetype->contains(location.row, object)) {
+                return nullptr;
+            }
+
+            return static_cast<T*>(location.archetype->component(location.row, T::type()));
+        }
+
+        void entityDestroyed(Object object);
+
+        [[nodiscard]] constexpr ALWAYS_INLINE const std::vector<Archetype*>& archetypes() const { return mArchetypeList; }
+
+        // Calls the callback once per chunk of every archetype matching the signature with the object column and
+        // one column per requested component.
+        template<typename ...Ts, typename Callback>
+        void eachChunk(const Signature &signature, Callback &&callback) const {
+            for (auto archetype : mArchetypeList) {
+                if ((archetype->signature() & signature) != signature) {
+                    continue;
+                }
+
+                for (std::size_t chunk = 0; chunk < archetype->chunkCount(); chunk++) {
+                    callback(archetype->chunkSize(chunk), archetype->objects(chunk), archetype->column<Ts>(chunk)...);
+                }
+            }
+        }
+    private:
+        struct Location {
+            Archetype *archetype { nullptr };
+            Archetype::Row row { 0, 0 };
+        };
+
+        // Chunks of every archetype come from one pool, freed chunks are reused by whichever archetype grows next
+        PoolAllocator<ArchetypeChunk> mChunkPool;
+
+        std::vector<Location> mLocations;
+        std::unordered_map<Signature, std::unique_ptr<Archetype>> mArchetypes;
+        std::vector<Archetype*> mArchetypeList;
+
+        Location& locationOf(Object object);
+        Archetype* getArchetype(const Signature &signature);
+
+        // Moves the object and its components that are part of the new signature into the matching archetype
+        Archetype::Row moveObject(Object object, Location &location, const Signature &signature);
+    };
+}
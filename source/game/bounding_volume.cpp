@@ -0,0 +1,5 @@
+#include "bounding_volume.h"
+
+namespace game {
+    REGISTER_COMPONENT(BoundingVolume);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "component.h"
+#include "math/aabb.h"
+
+namespace game {
+    // Bounds of a renderable relative to its Transform, objects without one are never culled
+    class BoundingVolume : public Component<BoundingVolume> {
+    public:
+        BoundingVolume() noexcept = default;
+
+        explicit BoundingVolume(const math::Aabb &bounds) noexcept : mBounds(bounds) {}
+
+        [[nodiscard]] const math::Aabb& bounds() const { return mBounds; }
+        void setBounds(const math::Aabb &bounds) { mBounds = bounds; }
+    private:
+        math::Aabb mBounds;
+    };
+}
@@ -1,10 +1,10 @@
 #pragma once
 
 #include "object.h"
-#include "engine/map.h"
-#include <unordered_map>
+#include "engine/vector.h"
 #include <optional>
 #include <stdexcept>
+#include <limits>
 
 namespace game {
     class IComponentArray {
@@ -13,66 +13,151 @@ namespace game {
         virtual void entityDestroyed(Object object) = 0;
     };
 
+    // Sparse set: components are packed densely in mComponents, mObjects holds the owning object of every dense
+    // slot and mSparse maps an object id to its dense slot.
     template <typename T>
     class ComponentArray : public IComponentArray {
     public:
+        static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+        class Iterator {
+        public:
+            Iterator(ComponentArray<T> &array, std::size_t index)
+                : mArray(array)
+                , mIndex(index)
+            {
+            }
+
+            Iterator& operator++() {
+                mIndex++;
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                Iterator tmp(*this);
+                operator++();
+                return tmp;
+            }
+
+            bool operator==(const Iterator &rhs) const {
+                return mIndex == rhs.mIndex;
+            }
+
+            T& operator*() {
+                return mArray.mComponents[mIndex];
+            }
+
+            T* operator->() {
+                return &mArray.mComponents[mIndex];
+            }
+
+            Object& key() {
+                return mArray.mObjects[mIndex];
+            }
+
+            T& value() {
+                return mArray.mComponents[mIndex];
+            }
+        private:
+            ComponentArray<T> &mArray;
+            std::size_t mIndex;
+        };
+
         explicit ComponentArray(Allocator &allocator)
             : mComponents(allocator)
+            , mObjects(allocator)
+            , mSparse(allocator)
         {
         }
 
         void insert(Object object, T component) {
-            if (mComponents.find(object) != mComponents.end()) {
+            if (contains(object)) {
                 throw std::runtime_error("Component already exists");
             }
 
-            mComponents.insert(object, component);
+            if (object.id() >= mSparse.size()) {
+                mSparse.resize(object.id() + 1, InvalidIndex);
+            }
 
-            mSize++;
+            mSparse[object.id()] = static_cast<uint32_t>(mComponents.size());
+            mComponents.push(std::move(component));
+            mObjects.push(object);
         }
 
         void remove(Object object) {
-            if (mComponents.find(object) == mComponents.end()) {
+            if (!contains(object)) {
                 throw std::runtime_error("Component does not exist");
             }
 
-            mComponents.remove(object);
+            // Keep the dense arrays packed by moving the last component into the freed slot
+            auto index = mSparse[object.id()];
+            auto lastIndex = static_cast<uint32_t>(mComponents.size() - 1);
 
-            mSize--;
+            if (index != lastIndex) {
+                mComponents[index] = std::move(mComponents.back());
+                mObjects[index] = mObjects.back();
+                mSparse[mObjects[index].id()] = index;
+            }
+
+            mComponents.pop();
+            mObjects.pop();
+            mSparse[object.id()] = InvalidIndex;
         }
 
         T& get(Object object) {
-            if (mComponents.find(object) == mComponents.end()) {
+            if (!contains(object)) {
                 throw std::runtime_error("Component does not exist");
             }
 
-            return mComponents[object];
+            return mComponents[mSparse[object.id()]];
         }
 
         T* getPtr(Object object) {
-            if (mComponents.find(object) == mComponents.end()) {
+            if (!contains(object)) {
                 return nullptr;
             }
 
-            return &mComponents[object];
+            return &mComponents[mSparse[object.id()]];
         }
 
         std::optional<T*> tryGetPtr(Object object) {
-            if (mComponents.find(object) == mComponents.end()) {
+            if (!contains(object)) {
                 return std::nullopt;
             }
 
-            return &mComponents[object];
+            return &mComponents[mSparse[object.id()]];
+        }
+
+        // Caller guarantees the object owns the component, e.g. through its signature
+        ALWAYS_INLINE T& getUnchecked(Object object) const {
+            return mComponents[mSparse[object.id()]];
+        }
+
+        [[nodiscard]] bool contains(Object object) const {
+            if (object.id() >= mSparse.size() || mSparse[object.id()] == InvalidIndex) {
+                return false;
+            }
+
+            // A stale handle shares the slot index but not the generation of the stored object
+            return mObjects[mSparse[object.id()]] == object;
         }
 
         void entityDestroyed(Object object) override {
-            remove(object);
+            if (contains(object)) {
+                remove(object);
+            }
         }
 
-        auto begin() { return mComponents.begin(); }
-        auto end() { return mComponents.end(); }
+        [[nodiscard]] constexpr ALWAYS_INLINE std::size_t size() const { return mComponents.size(); }
+
+        [[nodiscard]] constexpr ALWAYS_INLINE T* components() const { return mComponents.begin(); }
+        [[nodiscard]] constexpr ALWAYS_INLINE Object* objects() const { return mObjects.begin(); }
+
+        Iterator begin() { return { *this, 0 }; }
+        Iterator end() { return { *this, mComponents.size() }; }
     private:
-        HashMap<Object, T> mComponents;
-        size_t mSize { 0 };
+        Vector<T> mComponents;
+        Vector<Object> mObjects;
+        Vector<uint32_t> mSparse;
     };
-}
\ No newline at end of file
+}
@@ -7,6 +7,7 @@
 #include <stdexcept>
 #include <optional>
 #include <memory>
+#include <unordered_map>
 
 namespace game {
     class ComponentManager {
@@ -5,6 +5,7 @@
 #include "engine/engine.h"
 
 #include <algorithm>
+#include <unordered_map>
 #include <memory>
 
 namespace game {
@@ -12,13 +13,34 @@ namespace game {
         virtual ~IComponentArrayStaticData() = default;
 
         ComponentType type { 0 };
+        std::size_t size { 0 };
+        std::size_t alignment { 0 };
+
         [[nodiscard]] virtual std::shared_ptr<IComponentArray> createComponentArray() const = 0;
+
+        // Type erased operations used by storages that lay out components in raw memory
+        virtual void moveConstruct(void *destination, void *source) const = 0;
+        virtual void destruct(void *component) const = 0;
     };
 
     template <typename T>
     struct ComponentArrayStaticData : public IComponentArrayStaticData {
+        ComponentArrayStaticData() {
+            type = T::type();
+            size = sizeof(T);
+            alignment = alignof(T);
+        }
+
         [[nodiscard]] std::shared_ptr<IComponentArray> createComponentArray() const override {
-            return std::make_shared<ComponentArray<T>>(Engine::instance().allocator());
+            return std::make_shared<ComponentArray<T>>(Engine::instance().allocator(MemoryTag::Ecs));
+        }
+
+        void moveConstruct(void *destination, void *source) const override {
+            new (destination) T(std::move(*static_cast<T*>(source)));
+        }
+
+        void destruct(void *component) const override {
+            static_cast<T*>(component)->~T();
         }
     };
 
@@ -39,6 +61,15 @@ namespace game {
             return sComponents;
         }
 
+        [[nodiscard]] static const IComponentArrayStaticData& componentStaticData(ComponentType type) {
+            auto it = sComponents.find(type);
+            if (it == sComponents.end()) {
+                throw std::runtime_error("Component wasn't registered");
+            }
+
+            return *it->second;
+        }
+
     private:
         static inline ComponentArrayStaticDataMap sComponents;
     };
@@ -6,5 +6,4 @@ namespace game {
     using ComponentType = uint32_t;
 
     constexpr uint32_t MaxComponents = 32;
-    constexpr uint32_t MaxObjects = 1000;
 }
\ No newline at end of file
@@ -1,51 +1,97 @@
 #pragma once
 
-#include <queue>
-#include <array>
+#include <vector>
+#include <limits>
 #include <stdexcept>
-#include <cassert>
 #include "component_manager.h"
+#include "archetype.h"
+#include "view.h"
 
 namespace game {
+    enum class StorageMode {
+        // One sparse set per component type
+        ComponentArrays,
+        // Objects grouped by signature in chunked SoA archetypes
+        Archetypes,
+    };
+
     class Ecs {
     public:
-        Ecs() {
-            initializeObjects();
-            mComponentManager = std::make_unique<ComponentManager>(sComponentRegistry);
+        explicit Ecs(StorageMode storageMode = StorageMode::ComponentArrays)
+            : mStorageMode(storageMode)
+        {
+            if (mStorageMode == StorageMode::Archetypes) {
+                mArchetypeStorage = std::make_unique<ArchetypeStorage>(Engine::instance().allocator(MemoryTag::Ecs));
+            } else {
+                mComponentManager = std::make_unique<ComponentManager>(sComponentRegistry);
+            }
         }
 
         Ecs(const Ecs &) = delete;
         Ecs &operator=(const Ecs &other) = delete;
 
         Object createObject() {
-            if (mFreeObjects.empty()) {
-                throw std::runtime_error("Max objects amount exceeded.");
+            uint32_t id;
+
+            if (mFreeHead != InvalidObjectId) {
+                // Reuse a destroyed slot, its generation was already bumped on destruction
+                id = mFreeHead;
+                mFreeHead = mObjectSlots[id].nextFree;
+                mObjectSlots[id].nextFree = InvalidObjectId;
+            } else {
+                if (mObjectSlots.size() == InvalidObjectId) {
+                    throw std::runtime_error("Max objects amount exceeded.");
+                }
+
+                id = static_cast<uint32_t>(mObjectSlots.size());
+                mObjectSlots.push_back({ 0, InvalidObjectId });
+                mSignatures.emplace_back();
             }
 
-            auto id = mFreeObjects.front();
-            mFreeObjects.pop();
-
             mObjectCount++;
 
-            return Object { id };
+            return Object { id, mObjectSlots[id].generation, this };
         }
 
         void destroyObject(Object object) {
-            assert(object.id() <= MaxObjects);
-
-            mComponentManager->entityDestroyed(object);
+            if (!isAlive(object)) {
+                throw std::runtime_error("Stale object handle.");
+            }
 
-            mFreeObjects.push(object);
+            if (mArchetypeStorage) {
+                mArchetypeStorage->entityDestroyed(object);
+            } else {
+                mComponentManager->entityDestroyed(object);
+            }
 
             mSignatures[object.id()].reset();
-            mFreeObjects.push(object);
+
+            // Invalidate outstanding handles and push the slot on the intrusive free list
+            auto &slot = mObjectSlots[object.id()];
+            slot.generation++;
+            slot.nextFree = mFreeHead;
+            mFreeHead = object.id();
 
             mObjectCount--;
         }
 
+        [[nodiscard]] bool isAlive(Object object) const {
+            return object.id() < mObjectSlots.size() && mObjectSlots[object.id()].generation == object.generation();
+        }
+
+        [[nodiscard]] constexpr ALWAYS_INLINE uint32_t objectCount() const { return mObjectCount; }
+
         template<typename T>
         void addComponent(Object object, T component) {
-            mComponentManager->addComponent<T>(object, component);
+            if (!isAlive(object)) {
+                throw std::runtime_error("Stale object handle.");
+            }
+
+            if (mArchetypeStorage) {
+                mArchetypeStorage->addComponent<T>(object, component);
+            } else {
+                mComponentManager->addComponent<T>(object, component);
+            }
 
             auto &signature = mSignatures[object.id()];
             signature.set(T::type(), true);
@@ -53,7 +99,15 @@ namespace game {
 
         template<typename T>
         void removeComponent(Object object) {
-            mComponentManager->removeComponent<T>(object);
+            if (!isAlive(object)) {
+                throw std::runtime_error("Stale object handle.");
+            }
+
+            if (mArchetypeStorage) {
+                mArchetypeStorage->removeComponent<T>(object);
+            } else {
+                mComponentManager->removeComponent<T>(object);
+            }
 
             auto &signature = mSignatures[object.id()];
             signature.set(T::type(), false);
@@ -61,41 +115,75 @@ namespace game {
 
         template<typename T>
         T &getComponent(Object object) {
+            if (mArchetypeStorage) {
+                return mArchetypeStorage->getComponent<T>(object);
+            }
+
             return mComponentManager->getComponent<T>(object);
         }
 
         template<typename T>
         T* getComponentPtr(Object object) {
+            if (mArchetypeStorage) {
+                return mArchetypeStorage->getComponentPtr<T>(object);
+            }
+
             return mComponentManager->getComponentPtr<T>(object);
         }
 
         template<typename T>
         std::optional<T*> tryGetComponentPtr(Object object) {
+            if (mArchetypeStorage) {
+                auto component = mArchetypeStorage->getComponentPtr<T>(object);
+                return component ? std::optional<T*>(component) : std::nullopt;
+            }
+
             return mComponentManager->tryGetComponentPtr<T>(object);
         }
 
         template<typename T>
         bool hasComponent(Object object) {
-            return mSignatures[object.id()].test(T::type());
+            return isAlive(object) && mSignatures[object.id()].test(T::type());
         }
 
         template<typename T>
         std::shared_ptr<ComponentArray<T>> getComponentArray() {
+            if (mArchetypeStorage) {
+                throw std::runtime_error("Component arrays are not available in archetype storage mode");
+            }
+
             return mComponentManager->getComponentArray<T>();
         }
 
+        template<typename ...Ts>
+        View<Ts...> view() {
+            if (mArchetypeStorage) {
+                return View<Ts...>(*mArchetypeStorage);
+            }
+
+            return View<Ts...>(mSignatures.data(), mComponentManager->getComponentArray<Ts>().get()...);
+        }
+
+        [[nodiscard]] constexpr ALWAYS_INLINE StorageMode storageMode() const { return mStorageMode; }
+
     private:
-        std::queue<Object> mFreeObjects;
-        std::array<Signature, MaxObjects> mSignatures;
+        StorageMode mStorageMode;
+
+        static constexpr uint32_t InvalidObjectId = std::numeric_limits<uint32_t>::max();
+
+        struct ObjectSlot {
+            uint32_t generation;
+            // Next destroyed slot while this slot is on the free list
+            uint32_t nextFree;
+        };
+
+        std::vector<ObjectSlot> mObjectSlots;
+        std::vector<Signature> mSignatures;
+        uint32_t mFreeHead { InvalidObjectId };
         uint32_t mObjectCount = 0;
 
         std::unique_ptr<ComponentManager> mComponentManager;
-
-        void initializeObjects() {
-            for (uint32_t i = 0; i < MaxObjects; i++) {
-                mFreeObjects.emplace(i, this);
-            }
-        }
+        std::unique_ptr<ArchetypeStorage> mArchetypeStorage;
 
         static inline ComponentRegistry sComponentRegistry;
     };
@@ -6,16 +6,20 @@
 #include "platform/gcc.h"
 #include "constants.h"
 #include "engine/format.h"
+#include "engine/hash_policy.h"
 
 namespace game {
     class Ecs;
     using Signature = std::bitset<MaxComponents>;
 
+    // An entity handle is a 32-bit slot index plus a 32-bit generation. The generation of a slot is bumped every
+    // time its entity is destroyed, so handles to destroyed entities can be detected as stale.
     template<typename T>
     class Entity {
     public:
-        Entity(uint32_t id, T *manager)
+        Entity(uint32_t id, uint32_t generation, T *manager)
             : mId(id)
+            , mGeneration(generation)
             , mManager(manager)
         {}
 
@@ -23,12 +27,20 @@ namespace game {
             return mId;
         }
 
+        [[nodiscard]] constexpr ALWAYS_INLINE uint32_t generation() const {
+            return mGeneration;
+        }
+
+        [[nodiscard]] constexpr ALWAYS_INLINE uint64_t handle() const {
+            return (static_cast<uint64_t>(mGeneration) << 32) | mId;
+        }
+
         bool operator==(const Entity &other) const {
-            return mId == other.mId;
+            return mId == other.mId && mGeneration == other.mGeneration;
         }
 
         auto operator <=>(const Entity &other) const {
-            return mId <=> other.mId;
+            return handle() <=> other.handle();
         }
 
         template<typename C>
@@ -41,7 +53,8 @@ namespace game {
             mManager->template getComponent<C>(*this);
         }
     private:
-        uint32_t  mId;
+        uint32_t mId;
+        uint32_t mGeneration;
         T *mManager;
     };
 
@@ -52,13 +65,20 @@ namespace game {
 template<>
 struct FormatType<game::Object> {
     static std::string format(const game::Object &value) {
-        return formatString("Object({})", value.id());
+        return formatString("Object({}:{})", value.id(), value.generation());
+    }
+};
+
+template<typename T>
+struct DefaultHash<game::Entity<T>> {
+    ALWAYS_INLINE uint64_t operator()(const game::Entity<T> &entity) const {
+        return FibonacciHash {}(entity.handle());
     }
 };
 
 template<>
 struct std::hash<game::Object> {
     auto operator()(const game::Object object) const -> size_t {
-        return hash<uint32_t>()(object.id());
+        return hash<uint64_t>()(object.handle());
     }
 };
@@ -1,54 +1,68 @@
 #include "render_world.h"
 #include "ecs.h"
 #include "transform.h"
+#include "bounding_volume.h"
 #include "gfx/material_manager.h"
 #include "gfx/mesh_manager.h"
 
 namespace game {
     RenderWorld::RenderWorld(Universe &scene, Allocator &allocator, const math::Size2D &frameDimensions)
         : mScene(scene)
+        , mAllocator(allocator)
         , mRenderPipeline(gfx::RenderPipeline::createInstance(allocator, frameDimensions))
     {
         mRenderPipeline->initialize();
         mTerrain.initialize();
+
+        mObjectGrid = std::make_unique<SpatialGrid<gfx::RenderCommand>>(mAllocator, mTerrain.bounds(), ObjectCellSize);
     }
 
     void RenderWorld::render() {
+        const auto &camera = mRenderPipeline->camera();
+        math::Frustum frustum { camera.projection() * camera.view() };
+
         // Render terrain
-        renderTerrain();
+        renderTerrain(frustum);
 
         // Render objects
-        auto transformComponentArray = mScene.ecs().getComponentArray<Transform>();
+        auto &ecs = mScene.ecs();
+        mObjectGrid->clear();
+
+        // Looking the array up costs a hashed find per call, so fetch it once. Archetype lookups are direct already.
+        auto boundingVolumes = ecs.storageMode() == StorageMode::ComponentArrays ? ecs.getComponentArray<BoundingVolume>() : nullptr;
 
-        auto componentArray = mScene.ecs().getComponentArray<gfx::RenderComponent>();
-        for (auto it = componentArray->begin(); it != componentArray->end(); it++) {
-            const auto &object = it.key();
-            auto &component = it.value();
+        ecs.view<Transform, gfx::RenderComponent>().each([&](Object object, Transform &transform, gfx::RenderComponent &component) {
+            gfx::RenderCommand command { component.material(), component.mesh(), transform };
 
-            auto &transform = transformComponentArray->get(object);
-            gfx::RenderCommand command { component.material().get(), transform, component.mesh().get() };
+            auto boundingVolume = boundingVolumes ? boundingVolumes->tryGetPtr(object) : ecs.tryGetComponentPtr<BoundingVolume>(object);
+            if (!boundingVolume) {
+                mRenderPipeline->renderCommand(command);
+                return;
+            }
 
+            mObjectGrid->insert((*boundingVolume)->bounds().translated(transform.position()), command);
+        });
+
+        mObjectGrid->query(frustum, [this](const gfx::RenderCommand &command) {
             mRenderPipeline->renderCommand(command);
-        }
+        });
 
         mRenderPipeline->renderFrame();
     }
 
-    void RenderWorld::renderTerrain() {
-        auto terrainTransform = Transform(-50, 0, -80);
+    void RenderWorld::renderTerrain(const math::Frustum &frustum) {
+        mTerrain.update();
 
-        auto &terrainData = mTerrain.terrainData();
-        for (int i = 0; i < terrainData->size.width(); i++) {
-            for (int j = 0; j < terrainData->size.height(); j++) {
-                auto tileId = terrainData->tiles[i + j * terrainData->size.width()];
-                auto &tile = terrainData->tilesSet[tileId];
+        // Chunk vertices are already in world space
+        auto chunkTransform = Transform(0, 0, 0);
 
-                auto tileTransform = Transform(i * terrainData->tileSize * 1.05f + terrainTransform.position().x, 0, j * terrainData->tileSize * 1.05f + terrainTransform.position().z);
-
-                auto material = tile->material();
-                auto &mesh = tile->mesh();
+        for (const auto &chunk : mTerrain.chunks()) {
+            if (!frustum.intersects(chunk.bounds)) {
+                continue;
+            }
 
-                gfx::RenderCommand command { material.get(), tileTransform, mesh.get() };
+            for (const auto &batch : chunk.batches) {
+                gfx::RenderCommand command { batch.material, batch.mesh, chunkTransform };
                 mRenderPipeline->renderCommand(command);
             }
         }
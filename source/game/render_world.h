@@ -8,6 +8,8 @@
 #include "math/size.h"
 #include "gfx/render_pipeline.h"
 #include "terrain.h"
+#include "spatial_grid.h"
+#include "math/frustum.h"
 
 namespace game {
     class RenderWorld {
@@ -15,10 +17,15 @@ namespace game {
         explicit RenderWorld(Universe &scene, Allocator &allocator, const math::Size2D &frameDimensions);
         void resize(const math::Size2D &frameDimensions);
         void render();
-        void renderTerrain();
+        void renderTerrain(const math::Frustum &frustum);
     private:
+        static constexpr float ObjectCellSize = 8.0f;
+
         Universe &mScene;
+        Allocator &mAllocator;
         Terrain mTerrain;
         std::unique_ptr<gfx::RenderPipeline> mRenderPipeline;
+        // Bounded objects, refilled every frame so moving objects need no bookkeeping
+        std::unique_ptr<SpatialGrid<gfx::RenderCommand>> mObjectGrid;
     };
 }
@@ -1,15 +1,20 @@
 #include "scene.h"
 #include "engine/file_reader.h"
+#include "engine/engine.h"
 
 #include <json/reader.h>
 #include <unordered_map>
 
 namespace game {
-    Node* readNode(Universe *universe, Json::Value &object);
+    constexpr std::size_t NodesPerSlab = 64;
+
+    Node* readNode(PoolAllocator<Node> &pool, Universe *universe, Json::Value &object);
     Transform readTransform(Json::Value &object);
-    void readChildren(Universe *universe, Node *node, Json::Value &object);
+    void readChildren(PoolAllocator<Node> &pool, Universe *universe, Node *node, Json::Value &object);
 
-    Scene::Scene(Universe *universe, const Path &path) {
+    Scene::Scene(Universe *universe, const Path &path)
+        : mNodePool(Engine::instance().allocator(MemoryTag::Ecs), NodesPerSlab, std::max(sizeof(Node), sizeof(SpriteNode)))
+    {
         FileReader fileReader(path.value());
 
         Json::Reader reader;
@@ -17,14 +22,25 @@ namespace game {
 
         reader.parse(fileReader.getFileContent(), object);
 
-        mRoot = readNode(universe, object);
+        mRoot = readNode(mNodePool, universe, object);
         auto &children = object["children"];
         for (auto &child : children) {
-            mRoot->addChild(readNode(universe, child));
+            mRoot->addChild(readNode(mNodePool, universe, child));
+        }
+    }
+
+    Scene::~Scene() {
+        std::vector<Node*> nodes;
+        NodeIterator(mRoot).each([&nodes](Node *node) {
+            nodes.push_back(node);
+        });
+
+        for (auto node : nodes) {
+            mNodePool.destroy(node);
         }
     }
 
-    Node* readNode(Universe *universe, Json::Value &object) {
+    Node* readNode(PoolAllocator<Node> &pool, Universe *universe, Json::Value &object) {
         auto type = object["type"];
         auto transform = readTransform(object);
 
@@ -36,9 +52,9 @@ namespace game {
         auto nodeType = nodeTypeMap[type.asString()];
         switch (nodeType) {
             case NodeType::Node:
-                return new Node(universe, transform);
+                return pool.create(universe, transform);
             case NodeType::SpriteNode:
-                return new SpriteNode(universe, transform);
+                return pool.create<SpriteNode>(universe, transform);
         }
     }
 
@@ -53,12 +69,12 @@ namespace game {
         return Transform(x, y, z);
     }
 
-    void readChildren(Universe *universe, Node *node, Json::Value &object) {
+    void readChildren(PoolAllocator<Node> &pool, Universe *universe, Node *node, Json::Value &object) {
         auto &children = object["children"];
         for (auto &child : children) {
-            auto childNode = readNode(universe, child);
+            auto childNode = readNode(pool, universe, child);
             node->addChild(childNode);
-            readChildren(universe, childNode, child);
+            readChildren(pool, universe, childNode, child);
         }
     }
 }
\ No newline at end of file
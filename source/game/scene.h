@@ -2,14 +2,21 @@
 
 #include "node.h"
 #include "engine/path.h"
+#include "engine/pool_allocator.h"
 
 namespace game {
     class Scene {
     public:
         explicit Scene(Universe *universe, const Path &path);
+        ~Scene();
+
+        Scene(const Scene &) = delete;
+        Scene& operator=(const Scene &) = delete;
 
         [[nodiscard]] constexpr Node *root() const { return mRoot; }
     private:
+        // Slots fit every node type so the whole graph shares one pool
+        PoolAllocator<Node> mNodePool;
         Node *mRoot;
     };
 }
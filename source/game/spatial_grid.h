@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include "engine/vector.h"
+#include "math/aabb.h"
+#include "math/frustum.h"
+
+namespace game {
+    // Loose uniform grid over the xz plane. An item lives in the cell holding its center and the cell bounds grow to
+    // cover its items, so queries test the cells against the frustum first and only look at items of visible cells.
+    // Meant to be cleared and refilled every frame.
+    template<typename T>
+    class SpatialGrid {
+    public:
+        SpatialGrid(Allocator &allocator, const math::Aabb &worldBounds, float cellSize)
+            : mOrigin(worldBounds.min)
+            , mCellSize(cellSize)
+            , mColumns(std::max(1, static_cast<int>(std::ceil((worldBounds.max.x - worldBounds.min.x) / cellSize))))
+            , mRows(std::max(1, static_cast<int>(std::ceil((worldBounds.max.z - worldBounds.min.z) / cellSize))))
+            , mCells(allocator)
+            , mItems(allocator)
+        {
+            mCells.resize(mColumns * mRows);
+            clear();
+        }
+
+        void clear() {
+            for (auto &cell : mCells) {
+                cell = {};
+            }
+
+            mItems.clear();
+        }
+
+        void insert(const math::Aabb &bounds, const T &value) {
+            auto center = bounds.center();
+
+            // Items outside the world fall into the border cells, the loose bounds keep them correct
+            auto column = std::clamp(static_cast<int>(std::floor((center.x - mOrigin.x) / mCellSize)), 0, mColumns - 1);
+            auto row = std::clamp(static_cast<int>(std::floor((center.z - mOrigin.z) / mCellSize)), 0, mRows - 1);
+
+            auto &cell = mCells[column + row * mColumns];
+            cell.bounds.grow(bounds);
+
+            mItems.push({ bounds, value, cell.first });
+            cell.first = static_cast<uint32_t>(mItems.size() - 1);
+        }
+
+        template<typename Callback>
+        void query(const math::Frustum &frustum, Callback &&callback) const {
+            for (const auto &cell : mCells) {
+                if (cell.first == InvalidIndex || !frustum.intersects(cell.bounds)) {
+                    continue;
+                }
+
+                for (auto index = cell.first; index != InvalidIndex; index = mItems[index].next) {
+                    const auto &item = mItems[index];
+                    if (frustum.intersects(item.bounds)) {
+                        callback(item.value);
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]] constexpr ALWAYS_INLINE std::size_t size() const { return mItems.size(); }
+    private:
+        static constexpr uint32_t InvalidIndex = ~0u;
+
+        struct Cell {
+            math::Aabb bounds;
+            uint32_t first { InvalidIndex };
+        };
+
+        struct Item {
+            math::Aabb bounds;
+            T value;
+            uint32_t next;
+        };
+
+        glm::vec3 mOrigin;
+        float mCellSize;
+        int mColumns;
+        int mRows;
+
+        Vector<Cell> mCells;
+        Vector<Item> mItems;
+    };
+}
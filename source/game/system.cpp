@@ -0,0 +1,50 @@
+#include "system.h"
+
+#include <algorithm>
+
+namespace game {
+    bool System::conflictsWith(const System &other) const {
+        if (mExclusive || other.mExclusive) {
+            return true;
+        }
+
+        return (mWrites & (other.mReads | other.mWrites)).any() || (other.mWrites & mReads).any();
+    }
+
+    void SystemScheduler::addToPhase(System *system) {
+        std::size_t phase = 0;
+
+        for (std::size_t i = mPhases.size(); i > 0; i--) {
+            auto conflicts = std::any_of(mPhases[i - 1].begin(), mPhases[i - 1].end(), [system](const System *other) {
+                return system->conflictsWith(*other);
+            });
+
+            if (conflicts) {
+                phase = i;
+                break;
+            }
+        }
+
+        if (phase == mPhases.size()) {
+            mPhases.emplace_back();
+        }
+
+        mPhases[phase].push_back(system);
+    }
+
+    void SystemScheduler::update(Ecs &ecs, float dt) {
+        for (auto &phase : mPhases) {
+            if (phase.size() == 1) {
+                phase.front()->update(ecs, dt);
+                continue;
+            }
+
+            JobCounter counter;
+            for (auto system : phase) {
+                mJobSystem.schedule([system, &ecs, dt]() { system->update(ecs, dt); }, &counter);
+            }
+
+            mJobSystem.wait(counter);
+        }
+    }
+}
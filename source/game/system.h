@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "object.h"
+#include "engine/job_system.h"
+
+namespace game {
+    class Ecs;
+
+    // Systems declare the component types they read and write in their constructor, the scheduler uses these to run
+    // systems that don't touch the same data in parallel.
+    class System {
+    public:
+        virtual ~System() = default;
+
+        virtual void update(Ecs &ecs, float dt) = 0;
+
+        [[nodiscard]] constexpr ALWAYS_INLINE const Signature& reads() const { return mReads; }
+        [[nodiscard]] constexpr ALWAYS_INLINE const Signature& writes() const { return mWrites; }
+        [[nodiscard]] constexpr ALWAYS_INLINE bool exclusive() const { return mExclusive; }
+
+        [[nodiscard]] bool conflictsWith(const System &other) const;
+    protected:
+        template<typename ...Ts>
+        void read() {
+            (mReads.set(Ts::type(), true), ...);
+        }
+
+        template<typename ...Ts>
+        void write() {
+            (mWrites.set(Ts::type(), true), ...);
+        }
+
+        // Systems that create or destroy objects or add and remove components change the ecs structure and can't
+        // share a phase with any other system.
+        void setExclusive() {
+            mExclusive = true;
+        }
+    private:
+        Signature mReads;
+        Signature mWrites;
+        bool mExclusive { false };
+    };
+
+    // Groups the systems in phases. Systems within a phase don't conflict and run in parallel, phases run in order.
+    // A system is placed after the last phase holding a system it conflicts with, so conflicting systems keep the
+    // order in which they were added.
+    class SystemScheduler {
+    public:
+        explicit SystemScheduler(JobSystem &jobSystem)
+            : mJobSystem(jobSystem)
+        {
+        }
+
+        SystemScheduler(const SystemScheduler &) = delete;
+        SystemScheduler& operator=(const SystemScheduler &) = delete;
+
+        template<typename T, typename ...Args>
+        T& addSystem(Args&& ...args) {
+            auto system = std::make_unique<T>(std::forward<Args>(args)...);
+            auto &result = *system;
+
+            addToPhase(system.get());
+            mSystems.push_back(std::move(system));
+
+            return result;
+        }
+
+        void update(Ecs &ecs, float dt);
+
+        [[nodiscard]] ALWAYS_INLINE std::size_t phaseCount() const { return mPhases.size(); }
+    private:
+        JobSystem &mJobSystem;
+
+        std::vector<std::unique_ptr<System>> mSystems;
+        std::vector<std::vector<System*>> mPhases;
+
+        void addToPhase(System *system);
+    };
+}
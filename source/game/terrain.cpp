@@ -1,10 +1,140 @@
 #include "terrain.h"
 
+#include <algorithm>
 #include "gfx/material_manager.h"
+#include "gfx/mesh_manager.h"
 
 namespace game {
     void Terrain::initialize() {
         TerrainGenerator generator;
         mTerrainData = generator.generateTerrain("assets/terrain/forest");
+
+        auto width = mTerrainData->size.width();
+        auto height = mTerrainData->size.height();
+
+        mChunksPerRow = (width + ChunkSize - 1) / ChunkSize;
+        for (int y = 0; y < height; y += ChunkSize) {
+            for (int x = 0; x < width; x += ChunkSize) {
+                mChunks.push_back({ x, y });
+            }
+        }
+
+        update();
+    }
+
+    void Terrain::setTile(int x, int y, uint32_t tileId) {
+        auto &tile = mTerrainData->tiles[x + y * mTerrainData->size.width()];
+        if (tile == tileId) {
+            return;
+        }
+
+        tile = tileId;
+        mChunks[x / ChunkSize + (y / ChunkSize) * mChunksPerRow].dirty = true;
+    }
+
+    math::Aabb Terrain::bounds() const {
+        math::Aabb result;
+        for (const auto &chunk : mChunks) {
+            result.grow(chunk.bounds);
+        }
+
+        return result;
+    }
+
+    void Terrain::update() {
+        for (auto &chunk : mChunks) {
+            if (chunk.dirty) {
+                buildChunk(chunk);
+                chunk.dirty = false;
+            }
+        }
+    }
+
+    void Terrain::buildChunk(TerrainChunk &chunk) {
+        auto &meshManager = gfx::MeshManager::instance();
+
+        auto width = mTerrainData->size.width();
+        auto endX = std::min(chunk.x + ChunkSize, width);
+        auto endY = std::min(chunk.y + ChunkSize, mTerrainData->size.height());
+        auto tileCount = static_cast<std::size_t>((endX - chunk.x) * (endY - chunk.y));
+
+        auto tileAt = [&](int x, int y) -> TerrainTile& {
+            return *mTerrainData->tilesSet[mTerrainData->tiles[x + y * width]];
+        };
+
+        // Almost always a single material, tiles of other materials get a mesh of their own
+        std::vector<TerrainChunk::Batch> batches;
+        for (int y = chunk.y; y < endY; y++) {
+            for (int x = chunk.x; x < endX; x++) {
+                auto material = tileAt(x, y).material();
+                auto found = std::find_if(batches.begin(), batches.end(), [&](const auto &batch) {
+                    return batch.material.id() == material.id();
+                });
+
+                if (found == batches.end()) {
+                    batches.push_back({ material, {} });
+                }
+            }
+        }
+
+        // Scratch geometry of a full chunk is well over 100 KiB, too much for the fixed engine heap
+        std::vector<gfx::Vertex> vertices;
+        std::vector<uint32_t> indices;
+        vertices.reserve(tileCount * 4);
+        indices.reserve(tileCount * 6);
+
+        auto halfTile = static_cast<float>(mTerrainData->tileSize) / 2.0f;
+        auto step = static_cast<float>(mTerrainData->tileSize) * TileSpacing;
+        const glm::vec3 up { 0.0f, 1.0f, 0.0f };
+
+        chunk.bounds = {
+            mOrigin + glm::vec3(float(chunk.x) * step - halfTile, 0.0f, float(chunk.y) * step - halfTile),
+            mOrigin + glm::vec3(float(endX - 1) * step + halfTile, 0.0f, float(endY - 1) * step + halfTile),
+        };
+
+        for (auto &batch : batches) {
+            vertices.clear();
+            indices.clear();
+
+            for (int y = chunk.y; y < endY; y++) {
+                for (int x = chunk.x; x < endX; x++) {
+                    auto &tile = tileAt(x, y);
+                    if (tile.material().id() != batch.material.id()) {
+                        continue;
+                    }
+
+                    auto center = mOrigin + glm::vec3(float(x) * step, 0.0f, float(y) * step);
+
+                    auto first = static_cast<uint32_t>(vertices.size());
+                    vertices.push_back({ center + glm::vec3(halfTile, 0.0f, -halfTile), up, { 1.0f, 0.0f } });
+                    vertices.push_back({ center + glm::vec3(halfTile, 0.0f, halfTile), up, { 1.0f, 1.0f } });
+                    vertices.push_back({ center + glm::vec3(-halfTile, 0.0f, halfTile), up, { 0.0f, 1.0f } });
+                    vertices.push_back({ center + glm::vec3(-halfTile, 0.0f, -halfTile), up, { 0.0f, 0.0f } });
+                    gfx::remapTexCoords(vertices.data() + first, 4, tile.uvRect());
+
+                    const uint32_t quad[] = { first, first + 1, first + 3, first + 1, first + 2, first + 3 };
+                    indices.insert(indices.end(), quad, quad + 6);
+                }
+            }
+
+            auto existing = std::find_if(chunk.batches.begin(), chunk.batches.end(), [&](const auto &previous) {
+                return previous.material.id() == batch.material.id();
+            });
+
+            if (existing != chunk.batches.end()) {
+                batch.mesh = existing->mesh;
+                meshManager.updateMesh(batch.mesh, vertices.data(), vertices.size(), indices.data(), indices.size());
+                chunk.batches.erase(existing);
+            } else {
+                batch.mesh = meshManager.createMesh(vertices.data(), vertices.size(), indices.data(), indices.size());
+            }
+        }
+
+        // Materials no longer used in the chunk
+        for (auto &batch : chunk.batches) {
+            meshManager.destroyMesh(batch.mesh);
+        }
+
+        chunk.batches = std::move(batches);
     }
-}
\ No newline at end of file
+}
@@ -1,15 +1,34 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include "gfx/mesh.h"
 #include "gfx/material.h"
 #include "terrain_generator.h"
+#include "math/aabb.h"
 
 namespace game {
+    // A square block of tiles baked into one static mesh per material, vertices are in world space
+    struct TerrainChunk {
+        struct Batch {
+            gfx::MaterialHandle material;
+            gfx::MeshHandle mesh;
+        };
+
+        int x;
+        int y;
+        bool dirty { true };
+        math::Aabb bounds;
+        std::vector<Batch> batches;
+    };
 
     class Terrain {
     public:
+        static constexpr int ChunkSize = 32;
+        // Tiles are spaced slightly apart so the grid stays visible
+        static constexpr float TileSpacing = 1.05f;
+
         Terrain() = default;
 
         Terrain(const Terrain &other) = delete;
@@ -17,8 +36,24 @@ namespace game {
 
         void initialize();
 
+        void setTile(int x, int y, uint32_t tileId);
+
+        // Rebuilds the meshes of chunks whose tiles changed since the last update
+        void update();
+
+        [[nodiscard]] const std::vector<TerrainChunk>& chunks() const { return mChunks; }
+
+        // World space bounds of all tiles
+        [[nodiscard]] math::Aabb bounds() const;
+
         std::unique_ptr<TerrainData> &terrainData() { return mTerrainData; }
     private:
         std::unique_ptr<TerrainData> mTerrainData;
+        std::vector<TerrainChunk> mChunks;
+        int mChunksPerRow { 0 };
+
+        glm::vec3 mOrigin { -50.0f, 0.0f, -80.0f };
+
+        void buildChunk(TerrainChunk &chunk);
     };
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 #include "terrain_generator.h"
 
 #include "engine/file_reader.h"
+#include "gfx/texture_atlas.h"
 #include <fastwfc/tiling_wfc.hpp>
 #include <json/json.h>
 #include <unordered_map>
@@ -52,9 +53,11 @@ namespace game {
             Color color;
             glm::vec2 textCoordinatesPos;
             glm::vec2 textureSize;
+            std::string texture;
         };
 
         std::string textureMap;
+        std::string material;
         math::Size2D size;
         std::unordered_map<Color, Tile> tiles;
     };
@@ -188,6 +191,7 @@ namespace game {
         reader.parse(fileReader.getFileContent(), obj);
 
         result.textureMap = obj["textureMap"].asString();
+        result.material = obj["material"].isNull() ? "assets/material_scripts/background.lua" : obj["material"].asString();
 
         auto width = obj["width"].asInt();
         auto height = obj["height"].asInt();
@@ -199,6 +203,7 @@ namespace game {
                 .color = { static_cast<uint8_t>(tile["r"].asInt()), static_cast<uint8_t>(tile["g"].asInt()), static_cast<uint8_t>(tile["b"].asInt()) },
                 .textCoordinatesPos = {tile["x"].asInt(), tile["y"].asInt() },
                 .textureSize = { tile["width"].asInt(), tile["height"].asInt() },
+                .texture = tile["texture"].asString(),
             };
 
             tileData.id = id++;
@@ -208,49 +213,42 @@ namespace game {
         return result;
     }
 
-    std::unique_ptr<gfx::Mesh> generateTileMesh(const TilesMapData &map, const TilesMapData::Tile &tile, float tileSize) {
-        // This function can be optimized greatly
-        std::vector<gfx::Vertex> vertices;
+    glm::vec4 tileUvRect(const TilesMapData &map, const TilesMapData::Tile &tile) {
+        auto mapSize = glm::vec2(map.size.width(), map.size.height());
+        auto start = tile.textCoordinatesPos / mapSize;
+        auto end = (tile.textCoordinatesPos + tile.textureSize) / mapSize;
 
-        auto normalizedXStart = tile.textCoordinatesPos.x / (float) map.size.width();
-        auto normalizedYStart = tile.textCoordinatesPos.y / (float) map.size.height();
-        auto normalizedXEnd = (tile.textCoordinatesPos.x + tile.textureSize.x) / (float) map.size.width();
-        auto normalizedYEnd = (tile.textCoordinatesPos.y + tile.textureSize.y) / (float) map.size.height();
-
-        float tileStart = -tileSize / 2.0f;
-        float tileEnd = tileSize / 2.0f;
-
-        gfx::Vertex rightTop = { { tileEnd, 0.0f, tileStart }, { 0.0f, 1.0f, 0.0f }, { normalizedXEnd, normalizedYStart } };
-        gfx::Vertex rightBottom = { { tileEnd, 0.0f, tileEnd }, { 0.0f, 1.0f, 0.0f }, { normalizedXEnd, normalizedYEnd } };
-        gfx::Vertex leftBottom = { { tileStart, 0.0f, tileEnd }, { 0.0f, 1.0f, 0.0f }, { normalizedXStart, normalizedYEnd } };
-        gfx::Vertex leftTop = { { tileStart, 0.0f, tileStart }, { 0.0f, 1.0f, 0.0f }, { normalizedXStart, normalizedYStart } };
+        return { start.x, start.y, end.x, end.y };
+    }
 
-        vertices.push_back(rightTop);
-        vertices.push_back(rightBottom);
-        vertices.push_back(leftTop);
+    // Tiles with their own image are packed into one atlas, which the map's material binds as folder/atlas
+    std::optional<gfx::TextureAtlas> buildTileAtlas(const std::string &folder, const TilesMapData &map) {
+        gfx::TextureAtlasBuilder builder;
+        bool hasTextures = false;
 
-        vertices.push_back(rightBottom);
-        vertices.push_back(leftBottom);
-        vertices.push_back(leftTop);
+        for (const auto &[color, tile] : map.tiles) {
+            if (tile.texture.empty()) {
+                continue;
+            }
 
-        for (auto i = 0; i < vertices.size(); i += 3) {
-            auto& v1 = vertices[i];
-            auto& v2 = vertices[i + 1];
-            auto& v3 = vertices[i + 2];
+            if (!builder.add(tile.texture)) {
+                throw std::runtime_error("Failed to load tile texture " + tile.texture);
+            }
 
-            auto normal = glm::normalize(glm::cross(v3.position - v2.position, v3.position - v1.position));
+            hasTextures = true;
+        }
 
-            v1.normal = normal;
-            v2.normal = normal;
-            v3.normal = normal;
+        if (!hasTextures) {
+            return std::nullopt;
         }
 
-        return std::make_unique<gfx::Mesh>(vertices);
+        return builder.build(Path { folder + "/atlas" });
     }
 
     std::unique_ptr<TerrainData> TerrainGenerator::generateTerrain(const std::string &folder) {
         auto output = generateWfcImage(folder);
         auto map = readMap(folder);
+        auto atlas = buildTileAtlas(folder, map);
 
         auto result = std::make_unique<TerrainData>();
         result->size = { static_cast<int>(output.width), static_cast<int>(output.height) };
@@ -265,15 +263,14 @@ namespace game {
 
                 if (!result->tilesSet.contains(tile.id)) {
                     auto resultTile = std::make_shared<TerrainTile>();
-                    auto tileMesh = generateTileMesh(map, tile, 1.0f);
-
-                    resultTile->setMesh(std::move(tileMesh));
-                    resultTile->setMaterial(Path {"assets/material_scripts/background.lua"});
+                    auto atlasRect = atlas && !tile.texture.empty() ? atlas->uvRect(tile.texture) : std::nullopt;
+                    resultTile->setUvRect(atlasRect ? *atlasRect : tileUvRect(map, tile));
+                    resultTile->setMaterial(Path { map.material });
 
                     result->tilesSet.try_emplace(tile.id, resultTile);
                 }
 
-                result->tiles.push_back(tile.id);
+                result->tiles.push(tile.id);
             }
         }
 
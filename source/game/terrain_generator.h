@@ -3,13 +3,20 @@
 #include <string>
 #include "gfx/mesh.h"
 #include "tile_set.h"
+#include "engine/engine.h"
+#include "engine/vector.h"
 
 namespace game {
     struct TerrainData {
+        TerrainData()
+            : tiles(Engine::instance().allocator(MemoryTag::Terrain))
+        {
+        }
+
         math::Size2D size;
         int tileSize;
         std::unordered_map<int, std::shared_ptr<TerrainTile>> tilesSet;
-        std::vector<uint32_t> tiles;
+        Vector<uint32_t> tiles;
     };
 
     class TerrainGenerator {
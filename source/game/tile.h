@@ -8,13 +8,14 @@ namespace game {
     class TerrainTile {
     public:
         [[nodiscard]] gfx::MaterialHandle material() const { return mMaterial; }
-        std::unique_ptr<gfx::Mesh>& mesh() { return mTileMesh; }
+        // Normalized start and end corner of the tile in the terrain texture atlas
+        [[nodiscard]] const glm::vec4& uvRect() const { return mUvRect; }
 
-        void setMesh(std::unique_ptr<gfx::Mesh> &&mesh) { mTileMesh = std::move(mesh); }
+        void setUvRect(const glm::vec4 &uvRect) { mUvRect = uvRect; }
         void setMaterial(const Path &path);
 
     private:
         gfx::MaterialHandle mMaterial;
-        std::unique_ptr<gfx::Mesh> mTileMesh;
+        glm::vec4 mUvRect { 0.0f };
     };
 }
\ No newline at end of file
@@ -1,9 +1,8 @@
 #include "universe.h"
 #include "render_world.h"
 
-#include <cassert>
-
 #include "ecs.h"
+#include "system.h"
 #include "engine/application.h"
 #include "node.h"
 #include "scene.h"
@@ -32,7 +31,7 @@ namespace game {
         }
 
         void update(float dt) override {
-            throw std::runtime_error("Not implemented yet.");
+            mSystems.update(mEcs, dt);
         }
 
         void render() override {
@@ -44,17 +43,20 @@ namespace game {
         }
 
         void destroyObject(Object object) override {
-            assert(object.id() <= MaxObjects);
-
             mEcs.destroyObject(object);
         }
 
         Ecs& ecs() override {
             return mEcs;
         }
+
+        SystemScheduler& systems() override {
+            return mSystems;
+        }
     private:
         Allocator &mAllocator;
         Ecs mEcs;
+        SystemScheduler mSystems { Engine::instance().jobSystem() };
         std::unique_ptr<RenderWorld> mRenderWorld;
 
         Scene mScene;
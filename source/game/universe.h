@@ -7,6 +7,7 @@
 
 namespace game {
     class Ecs;
+    class SystemScheduler;
 
     class Universe {
     public:
@@ -22,5 +23,6 @@ namespace game {
         virtual void destroyObject(Object object) = 0;
 
         virtual Ecs& ecs() = 0;
+        virtual SystemScheduler& systems() = 0;
     };
 }
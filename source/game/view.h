@@ -0,0 +1,200 @@
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <limits>
+#include "object.h"
+#include "component_array.h"
+#include "archetype.h"
+#include "engine/job_system.h"
+
+namespace game {
+    constexpr std::size_t ViewBatchSize = 256;
+
+    // Iterates all objects that own every component in Ts.
+    // With component arrays the smallest array drives the iteration and the object signatures filter out objects that
+    // are missing any of the other components. With archetypes every matching archetype is walked chunk by chunk.
+    // Adding or removing components of the viewed types while iterating invalidates the view.
+    template<typename ...Ts>
+    class View {
+        static_assert(sizeof...(Ts) > 0, "View requires at least one component type");
+    public:
+        class Iterator {
+        public:
+            Iterator(const View &view, std::size_t index)
+                : mView(view)
+                , mIndex(index)
+            {
+                skipUnmatched();
+            }
+
+            Iterator& operator++() {
+                if (mView.mArchetypeStorage) {
+                    mRow++;
+                } else {
+                    mIndex++;
+                }
+
+                skipUnmatched();
+                return *this;
+            }
+
+            bool operator==(const Iterator &rhs) const {
+                return mIndex == rhs.mIndex && mChunk == rhs.mChunk && mRow == rhs.mRow;
+            }
+
+            std::tuple<Object, Ts&...> operator*() const {
+                if (mView.mArchetypeStorage) {
+                    auto archetype = mView.mArchetypeStorage->archetypes()[mIndex];
+                    return std::tuple<Object, Ts&...>(archetype->objects(mChunk)[mRow], archetype->template column<Ts>(mChunk)[mRow]...);
+                }
+
+                auto object = mView.mObjects[mIndex];
+                return std::tuple<Object, Ts&...>(object, std::get<ComponentArray<Ts>*>(mView.mArrays)->getUnchecked(object)...);
+            }
+        private:
+            const View &mView;
+            std::size_t mIndex;
+            std::size_t mChunk { 0 };
+            uint32_t mRow { 0 };
+
+            void skipUnmatched() {
+                if (!mView.mArchetypeStorage) {
+                    while (mIndex < mView.mSize && !mView.matches(mView.mObjects[mIndex])) {
+                        mIndex++;
+                    }
+
+                    return;
+                }
+
+                const auto &archetypes = mView.mArchetypeStorage->archetypes();
+                while (mIndex < archetypes.size()) {
+                    auto archetype = archetypes[mIndex];
+
+                    if ((archetype->signature() & mView.mSignature) == mView.mSignature) {
+                        while (mChunk < archetype->chunkCount()) {
+                            if (mRow < archetype->chunkSize(mChunk)) {
+                                return;
+                            }
+
+                            mChunk++;
+                            mRow = 0;
+                        }
+                    }
+
+                    mIndex++;
+                    mChunk = 0;
+                    mRow = 0;
+                }
+            }
+        };
+
+        View(const Signature *signatures, ComponentArray<Ts>* ...arrays)
+            : mSignatures(signatures)
+            , mArrays(arrays...)
+        {
+            (mSignature.set(Ts::type(), true), ...);
+
+            mSize = std::numeric_limits<std::size_t>::max();
+
+            auto pickSmallest = [this](auto *array) {
+                if (array->size() < mSize) {
+                    mObjects = array->objects();
+                    mSize = array->size();
+                }
+            };
+
+            (pickSmallest(arrays), ...);
+        }
+
+        explicit View(const ArchetypeStorage &archetypeStorage)
+            : mArchetypeStorage(&archetypeStorage)
+        {
+            (mSignature.set(Ts::type(), true), ...);
+        }
+
+        template<typename Callback>
+        void each(Callback &&callback) const {
+            if (mArchetypeStorage) {
+                mArchetypeStorage->eachChunk<Ts...>(mSignature, [&callback](uint32_t count, Object *objects, Ts* ...columns) {
+                    for (uint32_t row = 0; row < count; row++) {
+                        invoke(callback, objects[row], columns[row]...);
+                    }
+                });
+
+                return;
+            }
+
+            for (std::size_t i = 0; i < mSize; i++) {
+                auto object = mObjects[i];
+                if (!matches(object)) {
+                    continue;
+                }
+
+                invoke(callback, object, std::get<ComponentArray<Ts>*>(mArrays)->getUnchecked(object)...);
+            }
+        }
+
+        // Same as each, but spreads the objects over the job system. Archetype chunks become one job each, component
+        // arrays are split in batches. The callback runs concurrently and may only touch the components it is handed.
+        template<typename Callback>
+        void parallelEach(JobSystem &jobSystem, Callback &&callback, std::size_t batchSize = ViewBatchSize) const {
+            if (mArchetypeStorage) {
+                JobCounter counter;
+
+                mArchetypeStorage->eachChunk<Ts...>(mSignature, [&](uint32_t count, Object *objects, Ts* ...columns) {
+                    jobSystem.schedule([&callback, count, objects, columns...]() {
+                        for (uint32_t row = 0; row < count; row++) {
+                            invoke(callback, objects[row], columns[row]...);
+                        }
+                    }, &counter);
+                });
+
+                jobSystem.wait(counter);
+                return;
+            }
+
+            jobSystem.parallelFor(mSize, batchSize, [this, &callback](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; i++) {
+                    auto object = mObjects[i];
+                    if (!matches(object)) {
+                        continue;
+                    }
+
+                    invoke(callback, object, std::get<ComponentArray<Ts>*>(mArrays)->getUnchecked(object)...);
+                }
+            });
+        }
+
+        Iterator begin() const { return { *this, 0 }; }
+
+        Iterator end() const {
+            if (mArchetypeStorage) {
+                return { *this, mArchetypeStorage->archetypes().size() };
+            }
+
+            return { *this, mSize };
+        }
+    private:
+        const Signature *mSignatures { nullptr };
+        std::tuple<ComponentArray<Ts>*...> mArrays;
+        const ArchetypeStorage *mArchetypeStorage { nullptr };
+        Signature mSignature;
+
+        Object *mObjects { nullptr };
+        std::size_t mSize { 0 };
+
+        [[nodiscard]] ALWAYS_INLINE bool matches(Object object) const {
+            return (mSignatures[object.id()] & mSignature) == mSignature;
+        }
+
+        template<typename Callback>
+        static ALWAYS_INLINE void invoke(Callback &callback, Object object, Ts& ...components) {
+            if constexpr (std::is_invocable_v<Callback, Object, Ts&...>) {
+                callback(object, components...);
+            } else {
+                callback(components...);
+            }
+        }
+    };
+}
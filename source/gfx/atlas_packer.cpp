@@ -0,0 +1,120 @@
+#include "atlas_packer.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace gfx {
+    SkylinePacker::SkylinePacker(math::Size2D size)
+        : mSize(size)
+    {
+        reset();
+    }
+
+    std::optional<glm::ivec2> SkylinePacker::insert(math::Size2D size) {
+        int bestY = std::numeric_limits<int>::max();
+        int bestWaste = std::numeric_limits<int>::max();
+        std::optional<std::size_t> bestIndex;
+
+        for (std::size_t i = 0; i < mSkyline.size(); i++) {
+            auto y = fit(i, size);
+            if (!y) {
+                continue;
+            }
+
+            auto top = *y + size.height();
+            if (top > bestY) {
+                continue;
+            }
+
+            auto waste = wastedArea(i, size.width(), *y);
+            if (top < bestY || waste < bestWaste) {
+                bestY = top;
+                bestWaste = waste;
+                bestIndex = i;
+            }
+        }
+
+        if (!bestIndex) {
+            return std::nullopt;
+        }
+
+        glm::ivec2 position { mSkyline[*bestIndex].x, bestY - size.height() };
+        addSegment(*bestIndex, { position.x, bestY, size.width() });
+        mUsedArea += long(size.width()) * size.height();
+
+        return position;
+    }
+
+    void SkylinePacker::reset() {
+        mSkyline.clear();
+        mSkyline.push_back({ 0, 0, mSize.width() });
+        mUsedArea = 0;
+    }
+
+    float SkylinePacker::occupancy() const {
+        return float(mUsedArea) / (float(mSize.width()) * float(mSize.height()));
+    }
+
+    std::optional<int> SkylinePacker::fit(std::size_t index, math::Size2D size) const {
+        auto x = mSkyline[index].x;
+        if (x + size.width() > mSize.width()) {
+            return std::nullopt;
+        }
+
+        // Rest on the highest segment under the rectangle
+        int y = 0;
+        int remaining = size.width();
+        for (auto i = index; remaining > 0; i++) {
+            y = std::max(y, mSkyline[i].y);
+            if (y + size.height() > mSize.height()) {
+                return std::nullopt;
+            }
+
+            remaining -= mSkyline[i].width;
+        }
+
+        return y;
+    }
+
+    int SkylinePacker::wastedArea(std::size_t index, int width, int y) const {
+        int waste = 0;
+        auto left = mSkyline[index].x;
+        auto right = left + width;
+
+        for (auto i = index; i < mSkyline.size() && mSkyline[i].x < right; i++) {
+            auto segmentRight = std::min(mSkyline[i].x + mSkyline[i].width, right);
+            waste += (segmentRight - mSkyline[i].x) * (y - mSkyline[i].y);
+        }
+
+        return waste;
+    }
+
+    void SkylinePacker::addSegment(std::size_t index, const Segment &segment) {
+        mSkyline.insert(mSkyline.begin() + static_cast<std::ptrdiff_t>(index), segment);
+
+        // Cut the segments now covered by the new one
+        auto right = segment.x + segment.width;
+        auto i = index + 1;
+        while (i < mSkyline.size() && mSkyline[i].x < right) {
+            auto overlap = right - mSkyline[i].x;
+            if (overlap >= mSkyline[i].width) {
+                mSkyline.erase(mSkyline.begin() + static_cast<std::ptrdiff_t>(i));
+                continue;
+            }
+
+            mSkyline[i].x += overlap;
+            mSkyline[i].width -= overlap;
+            break;
+        }
+
+        // Merge neighbours at the same height
+        for (std::size_t j = 0; j + 1 < mSkyline.size();) {
+            if (mSkyline[j].y == mSkyline[j + 1].y) {
+                mSkyline[j].width += mSkyline[j + 1].width;
+                mSkyline.erase(mSkyline.begin() + static_cast<std::ptrdiff_t>(j + 1));
+            } else {
+                j++;
+            }
+        }
+    }
+}
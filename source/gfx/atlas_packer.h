@@ -0,0 +1,40 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "math/size.h"
+
+namespace gfx {
+    // Packs rectangles into a fixed area by tracking the top edge of everything placed so far as a list of horizontal
+    // segments. Each rectangle goes where its top ends lowest, ties go to the least wasted area underneath.
+    class SkylinePacker {
+    public:
+        explicit SkylinePacker(math::Size2D size);
+
+        // Returns the corner of the placed rectangle, or nothing when it doesn't fit
+        std::optional<glm::ivec2> insert(math::Size2D size);
+
+        void reset();
+
+        [[nodiscard]] const math::Size2D& size() const { return mSize; }
+
+        // Fraction of the area taken by placed rectangles
+        [[nodiscard]] float occupancy() const;
+    private:
+        struct Segment {
+            int x;
+            int y;
+            int width;
+        };
+
+        math::Size2D mSize;
+        std::vector<Segment> mSkyline;
+        long mUsedArea { 0 };
+
+        // Height the rectangle would rest at when its left edge is at segment index, nothing when it sticks out
+        [[nodiscard]] std::optional<int> fit(std::size_t index, math::Size2D size) const;
+        [[nodiscard]] int wastedArea(std::size_t index, int width, int y) const;
+        void addSegment(std::size_t index, const Segment &segment);
+    };
+}
@@ -2,8 +2,10 @@
 #include "camera.h"
 
 namespace gfx {
-    Camera::Camera(const math::Size2D &size) {
-        mProjection = glm::perspective(glm::radians(45.0f), float(size.width()) / float(size.height()), 0.1f, 1000.0f);
+    Camera::Camera(const math::Size2D &size)
+        : mSize(size)
+    {
+        mProjection = glm::perspective(glm::radians(45.0f), float(size.width()) / float(size.height()), NearPlane, FarPlane);
 
         auto camTarget = glm::vec3(0.0f);
         auto camPos = glm::vec3(0.0f, 10.0f, 10.0f);
@@ -12,6 +14,7 @@ namespace gfx {
     }
 
     void Camera::resize(const math::Size2D &size) {
-        mProjection = glm::perspective(glm::radians(45.0f), float(size.width()) / float(size.height()), 0.1f, 1000.0f);
+        mSize = size;
+        mProjection = glm::perspective(glm::radians(45.0f), float(size.width()) / float(size.height()), NearPlane, FarPlane);
     }
 }
\ No newline at end of file
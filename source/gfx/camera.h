@@ -6,13 +6,18 @@
 namespace gfx {
     class Camera {
     public:
+        static constexpr float NearPlane = 0.1f;
+        static constexpr float FarPlane = 1000.0f;
+
         explicit Camera(const math::Size2D &size);
 
         void resize(const math::Size2D &size);
 
         [[nodiscard]] const glm::mat4& view() const { return mView; }
         [[nodiscard]] const glm::mat4& projection() const { return mProjection; }
+        [[nodiscard]] const math::Size2D& size() const { return mSize; }
     private:
+        math::Size2D mSize;
         glm::mat4 mProjection { 1.0f };
         glm::mat4 mView { 1.0f };
     };
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <array>
+#include "command_buffer.h"
+
+namespace gfx {
+    namespace sortkey {
+        static constexpr uint64_t mask(uint32_t bits) {
+            return (uint64_t(1) << bits) - 1;
+        }
+
+        uint64_t make(RenderPass pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth) {
+            depth = std::clamp(depth, 0.0f, 1.0f);
+            if (pass == RenderPass::Transparent) {
+                depth = 1.0f - depth;
+            }
+
+            auto quantizedDepth = static_cast<uint64_t>(depth * float(mask(DepthBits)));
+
+            return (uint64_t(pass) & mask(PassBits)) << PassShift
+                | (uint64_t(shader) & mask(ShaderBits)) << ShaderShift
+                | (uint64_t(material) & mask(MaterialBits)) << MaterialShift
+                | (uint64_t(mesh) & mask(MeshBits)) << MeshShift
+                | quantizedDepth;
+        }
+    }
+
+    CommandBuffer::CommandBuffer(Allocator &allocator)
+        : mCommands(allocator)
+        , mEntries(allocator)
+        , mScratch(allocator)
+    {
+    }
+
+    void CommandBuffer::submit(const RenderCommand &command, uint64_t key) {
+        mEntries.push({ key, static_cast<uint32_t>(mCommands.size()) });
+        mCommands.push(command);
+    }
+
+    void CommandBuffer::sort() {
+        constexpr uint32_t RadixBits = 8;
+        constexpr uint32_t Buckets = 1 << RadixBits;
+        constexpr uint32_t Passes = 64 / RadixBits;
+
+        auto count = mEntries.size();
+        if (count < 2) {
+            return;
+        }
+
+        // All histograms in one sweep over the keys
+        std::array<std::array<uint32_t, Buckets>, Passes> histograms {};
+        for (const auto &entry : mEntries) {
+            for (uint32_t pass = 0; pass < Passes; pass++) {
+                histograms[pass][(entry.key >> (pass * RadixBits)) & (Buckets - 1)]++;
+            }
+        }
+
+        mScratch.resize(count);
+
+        auto source = mEntries.data();
+        auto destination = mScratch.data();
+
+        for (uint32_t pass = 0; pass < Passes; pass++) {
+            auto &histogram = histograms[pass];
+            auto shift = pass * RadixBits;
+
+            // Keys sharing this digit, like the pass bits most frames, need no scatter
+            if (histogram[(source[0].key >> shift) & (Buckets - 1)] == count) {
+                continue;
+            }
+
+            uint32_t offset = 0;
+            for (auto &bucket : histogram) {
+                auto bucketCount = bucket;
+                bucket = offset;
+                offset += bucketCount;
+            }
+
+            for (std::size_t i = 0; i < count; i++) {
+                auto &entry = source[i];
+                destination[histogram[(entry.key >> shift) & (Buckets - 1)]++] = entry;
+            }
+
+            std::swap(source, destination);
+        }
+
+        if (source != mEntries.data()) {
+            std::copy(source, source + count, mEntries.data());
+        }
+    }
+
+    void CommandBuffer::reserve(std::size_t count) {
+        mCommands.reserve(count);
+        mEntries.reserve(count);
+        mScratch.reserve(count);
+    }
+
+    void CommandBuffer::reset() {
+        mCommands.reset();
+        mEntries.reset();
+        mScratch.reset();
+    }
+}
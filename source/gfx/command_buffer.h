@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include "engine/vector.h"
+#include "mesh.h"
+#include "material.h"
+#include "game/transform.h"
+
+namespace gfx {
+    struct RenderCommand {
+        MaterialHandle material;
+        MeshHandle mesh;
+        game::Transform transform;
+    };
+
+    enum class RenderPass : uint8_t {
+        Opaque,
+        Transparent,
+    };
+
+    // Commands are ordered by pass, shader, material, mesh and finally depth, from the high to the low bits of the key.
+    // Ids wider than their field wrap around, that only costs some state changes since the pipeline compares full ids.
+    namespace sortkey {
+        constexpr uint32_t DepthBits = 22;
+        constexpr uint32_t MeshBits = 14;
+        constexpr uint32_t MaterialBits = 14;
+        constexpr uint32_t ShaderBits = 12;
+        constexpr uint32_t PassBits = 2;
+
+        constexpr uint32_t MeshShift = DepthBits;
+        constexpr uint32_t MaterialShift = MeshShift + MeshBits;
+        constexpr uint32_t ShaderShift = MaterialShift + MaterialBits;
+        constexpr uint32_t PassShift = ShaderShift + ShaderBits;
+
+        static_assert(PassShift + PassBits == 64);
+
+        // Depth is expected in [0, 1], opaque geometry sorts front to back and transparent geometry back to front
+        uint64_t make(RenderPass pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth);
+    }
+
+    // Per frame list of render commands with their sort keys. The commands stay where they were submitted, sorting
+    // only shuffles 16 byte key and index pairs.
+    class CommandBuffer {
+    public:
+        explicit CommandBuffer(Allocator &allocator);
+
+        void submit(const RenderCommand &command, uint64_t key);
+
+        // Radix sorts the keys, commands with equal keys keep their submission order
+        void sort();
+
+        void reserve(std::size_t count);
+        void reset();
+
+        [[nodiscard]] constexpr ALWAYS_INLINE std::size_t size() const { return mCommands.size(); }
+        [[nodiscard]] constexpr ALWAYS_INLINE std::size_t capacity() const { return mCommands.capacity(); }
+
+        // Commands in sorted order once sort has been called
+        [[nodiscard]] ALWAYS_INLINE const RenderCommand& operator[](std::size_t index) const {
+            return mCommands[mEntries[index].index];
+        }
+
+        [[nodiscard]] ALWAYS_INLINE uint64_t key(std::size_t index) const {
+            return mEntries[index].key;
+        }
+    private:
+        struct Entry {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        Vector<RenderCommand> mCommands;
+        Vector<Entry> mEntries;
+        Vector<Entry> mScratch;
+    };
+}
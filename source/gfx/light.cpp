@@ -1,78 +1,90 @@
 #include "light.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace gfx {
-    Lights::Lights(const std::vector<DirLight> &dirLights, const std::vector<PointLight> &pointLights)
-            : mDirLightsCount(static_cast<int>(dirLights.size()))
-            , mDirLights(dirLights)
-            , mPointLightsCount(static_cast<int>(pointLights.size()))
-            , mPointLights(pointLights)
-    {
-        mLayout = std::make_unique<gpu::BufferLayout>();
-        mLayout->addAttribute("dirLightsCount", sizeof(int));
-        mLayout->padLastAttribute();
-
-        for (int i = 0; i < MaxDirLights; i++) {
-            mLayout->addAttribute("dirLights[" + std::to_string(i) + "].direction", sizeof(glm::vec3));
-            mLayout->addAttribute("dirLights[" + std::to_string(i) + "].ambient", sizeof(glm::vec3));
-            mLayout->addAttribute("dirLights[" + std::to_string(i) + "].diffuse", sizeof(glm::vec3));
-            mLayout->addAttribute("dirLights[" + std::to_string(i) + "].specular", sizeof(glm::vec3));
-
-            mLayout->padLastAttribute();
+    Lights::Lights(const std::vector<DirLight> &dirLights, const std::vector<PointLight> &pointLights) {
+        mBuffer = gpu::SharedUniformBuffer::create(LightsBlockBinding, sizeof(LightsBlock));
+        mClusters = std::make_unique<LightClusters>();
+
+        mBlock.clusterSize = mClusters->gridSize();
+        markDirty(&mBlock.clusterSize, sizeof(glm::uvec4));
+
+        setDirLightsCount(static_cast<int>(dirLights.size()));
+        for (int i = 0; i < mBlock.dirLightsCount; i++) {
+            setDirLight(i, dirLights[i]);
         }
 
-        mLayout->addAttribute("pointLightsCount", sizeof(int));
+        setPointLightsCount(static_cast<int>(pointLights.size()));
+        for (int i = 0; i < pointLightsCount(); i++) {
+            setPointLight(i, pointLights[i]);
+        }
+    }
 
-        for (int i = 0; i < MaxPointLights; i++) {
-            mLayout->addAttribute("pointLights[" + std::to_string(i) + "].position", sizeof(glm::vec3));
-            mLayout->addAttribute("pointLights[" + std::to_string(i) + "].ambient", sizeof(glm::vec3));
-            mLayout->addAttribute("pointLights[" + std::to_string(i) + "].diffuse", sizeof(glm::vec3));
-            mLayout->addAttribute("pointLights[" + std::to_string(i) + "].specular", sizeof(glm::vec3));
-            mLayout->addAttribute("pointLights[" + std::to_string(i) + "].constant", sizeof(float));
-            mLayout->addAttribute("pointLights[" + std::to_string(i) + "].linear", sizeof(float));
-            mLayout->addAttribute("pointLights[" + std::to_string(i) + "].quadratic", sizeof(float));
+    void Lights::setDirLight(int index, const DirLight &light) {
+        if (index < 0 || index >= MaxDirLights) {
+            throw std::runtime_error("Directional light index out of range");
+        }
 
-            mLayout->padLastAttribute();
+        mBlock.dirLights[index] = light;
+        markDirty(&mBlock.dirLights[index], sizeof(DirLight));
+    }
+
+    void Lights::setDirLightsCount(int count) {
+        if (count < 0 || count > MaxDirLights) {
+            throw std::runtime_error("Too many directional lights");
         }
 
-        mBuffer = gpu::SharedUniformBuffer::create(LightsBlockBinding, mLayout->totalSize());
+        mBlock.dirLightsCount = count;
+        markDirty(&mBlock.dirLightsCount, sizeof(int32_t));
     }
 
-    void Lights::setBufferData() {
-        auto dirLightsCountOffset = mLayout->attribute("dirLightsCount").offset;
+    void Lights::setPointLight(int index, const PointLight &light) {
+        if (index < 0 || index >= pointLightsCount()) {
+            throw std::runtime_error("Point light index out of range");
+        }
 
-        mBuffer->setData(dirLightsCountOffset, &mDirLightsCount, sizeof(int));
+        mPointLights[index] = light;
+    }
 
-        for (int i = 0; i < mDirLightsCount; i++) {
-            auto directionOffset = mLayout->attribute("dirLights[" + std::to_string(i) + "].direction").offset;
-            auto ambientOffset = mLayout->attribute("dirLights[" + std::to_string(i) + "].ambient").offset;
-            auto diffuseOffset = mLayout->attribute("dirLights[" + std::to_string(i) + "].diffuse").offset;
-            auto specularOffset = mLayout->attribute("dirLights[" + std::to_string(i) + "].specular").offset;
+    void Lights::setPointLightsCount(int count) {
+        if (count < 0 || count > MaxPointLights) {
+            throw std::runtime_error("Too many point lights");
+        }
 
-            mBuffer->setData(directionOffset, &mDirLights[i].direction, sizeof(glm::vec3));
-            mBuffer->setData(ambientOffset, &mDirLights[i].ambient, sizeof(glm::vec3));
-            mBuffer->setData(diffuseOffset, &mDirLights[i].diffuse, sizeof(glm::vec3));
-            mBuffer->setData(specularOffset, &mDirLights[i].specular, sizeof(glm::vec3));
+        mPointLights.resize(count);
+    }
+
+    void Lights::flush(const Camera &camera) {
+        if (mBuffer == nullptr) {
+            return;
+        }
+
+        mClusters->update(camera, mPointLights);
+        mClusters->bind();
+
+        auto clusterParams = mClusters->gridParams(camera);
+        if (clusterParams != mBlock.clusterParams) {
+            mBlock.clusterParams = clusterParams;
+            markDirty(&mBlock.clusterParams, sizeof(glm::vec4));
         }
 
-        auto pointLightsCountOffset = mLayout->attribute("pointLightsCount").offset;
-        mBuffer->setData(pointLightsCountOffset, &mPointLightsCount, sizeof(int));
-
-        for (int i = 0; i < mPointLightsCount; i++) {
-            auto positionOffset = mLayout->attribute("pointLights[" + std::to_string(i) + "].position").offset;
-            auto ambientOffset = mLayout->attribute("pointLights[" + std::to_string(i) + "].ambient").offset;
-            auto diffuseOffset = mLayout->attribute("pointLights[" + std::to_string(i) + "].diffuse").offset;
-            auto specularOffset = mLayout->attribute("pointLights[" + std::to_string(i) + "].specular").offset;
-            auto constantOffset = mLayout->attribute("pointLights[" + std::to_string(i) + "].constant").offset;
-            auto linearOffset = mLayout->attribute("pointLights[" + std::to_string(i) + "].linear").offset;
-            auto quadraticOffset = mLayout->attribute("pointLights[" + std::to_string(i) + "].quadratic").offset;
-
-            mBuffer->setData(positionOffset, &mPointLights[i].position, sizeof(glm::vec3));
-            mBuffer->setData(ambientOffset, &mPointLights[i].ambient, sizeof(glm::vec3));
-            mBuffer->setData(diffuseOffset, &mPointLights[i].diffuse, sizeof(glm::vec3));
-            mBuffer->setData(specularOffset, &mPointLights[i].specular, sizeof(glm::vec3));
-            mBuffer->setData(constantOffset, &mPointLights[i].constant, sizeof(float));
-            mBuffer->setData(linearOffset, &mPointLights[i].linear, sizeof(float));
-            mBuffer->setData(quadraticOffset, &mPointLights[i].quadratic, sizeof(float));
+        if (mDirtyBegin >= mDirtyEnd) {
+            return;
         }
+
+        auto data = reinterpret_cast<std::byte*>(&mBlock) + mDirtyBegin;
+        mBuffer->setData(mDirtyBegin, data, mDirtyEnd - mDirtyBegin);
+
+        mDirtyBegin = sizeof(LightsBlock);
+        mDirtyEnd = 0;
+    }
+
+    void Lights::markDirty(const void *member, uint32_t size) {
+        auto offset = static_cast<uint32_t>(static_cast<const std::byte*>(member) - reinterpret_cast<const std::byte*>(&mBlock));
+
+        mDirtyBegin = std::min(mDirtyBegin, offset);
+        mDirtyEnd = std::max(mDirtyEnd, offset + size);
     }
-}
\ No newline at end of file
+}
@@ -1,17 +1,25 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
+#include <vector>
 #include <glm/glm.hpp>
 #include "gpu/gpu.h"
+#include "platform/gcc.h"
+#include "camera.h"
+#include "light_clusters.h"
 #include "shader.h"
 
 namespace gfx {
+    // Mirrors its std140 counterpart in the Lights block, so it can be copied into the uniform buffer as a whole
     struct DirLight {
-        glm::vec3 direction;
-        glm::vec3 ambient;
-        glm::vec3 diffuse;
-        glm::vec3 specular;
+        alignas(16) glm::vec3 direction;
+        alignas(16) glm::vec3 ambient;
+        alignas(16) glm::vec3 diffuse;
+        alignas(16) glm::vec3 specular;
     };
 
+    // Stored in a buffer texture and binned into light clusters instead of living in the Lights block
     struct PointLight {
         glm::vec3 position;
         glm::vec3 ambient;
@@ -23,23 +31,70 @@ namespace gfx {
     };
 
     constexpr int MaxDirLights = 4;
-    constexpr int MaxPointLights = 8;
+    // Light indices are uploaded as 16 bit
+    constexpr int MaxPointLights = 4096;
+
+    struct LightsBlock {
+        int32_t dirLightsCount;
+        DirLight dirLights[MaxDirLights];
+        alignas(16) glm::uvec4 clusterSize;
+        // Tile width and height in pixels, then the scale and bias turning log(depth) into a depth slice
+        alignas(16) glm::vec4 clusterParams;
+    };
+
+    namespace detail {
+        // Offset std140 gives a member of the given size following a member that ends at end
+        constexpr uint32_t std140After(std::size_t end, std::size_t size) {
+            return gpu::alignOffset(end, gpu::std140Alignment(size));
+        }
+
+        constexpr uint32_t std140StructAfter(std::size_t end) {
+            return gpu::alignOffset(end, gpu::Std140StructAlignment);
+        }
+    }
+
+    static_assert(offsetof(DirLight, direction) == 0);
+    static_assert(offsetof(DirLight, ambient) == detail::std140After(offsetof(DirLight, direction) + 12, 12));
+    static_assert(offsetof(DirLight, diffuse) == detail::std140After(offsetof(DirLight, ambient) + 12, 12));
+    static_assert(offsetof(DirLight, specular) == detail::std140After(offsetof(DirLight, diffuse) + 12, 12));
+    static_assert(sizeof(DirLight) == detail::std140StructAfter(offsetof(DirLight, specular) + 12));
 
+    static_assert(offsetof(LightsBlock, dirLightsCount) == 0);
+    static_assert(offsetof(LightsBlock, dirLights) == detail::std140StructAfter(sizeof(int32_t)));
+    static_assert(offsetof(LightsBlock, clusterSize)
+                  == detail::std140After(offsetof(LightsBlock, dirLights) + sizeof(DirLight) * MaxDirLights, 16));
+    static_assert(offsetof(LightsBlock, clusterParams) == detail::std140After(offsetof(LightsBlock, clusterSize) + 16, 16));
+
+    // Keeps a CPU copy of the Lights block. Setters only mark the bytes they change, flush uploads the dirty range
+    // in a single call so lights can be changed every frame. Point lights are binned into clusters on every flush.
     class Lights {
     public:
         Lights() = default;
         Lights(const std::vector<DirLight> &dirLights, const std::vector<PointLight> &pointLights);
 
-        void setBufferData();
+        void setDirLight(int index, const DirLight &light);
+        void setDirLightsCount(int count);
+
+        void setPointLight(int index, const PointLight &light);
+        void setPointLightsCount(int count);
+
+        [[nodiscard]] constexpr ALWAYS_INLINE const DirLight& dirLight(int index) const { return mBlock.dirLights[index]; }
+        [[nodiscard]] constexpr ALWAYS_INLINE int dirLightsCount() const { return mBlock.dirLightsCount; }
+
+        [[nodiscard]] ALWAYS_INLINE const PointLight& pointLight(int index) const { return mPointLights[index]; }
+        [[nodiscard]] ALWAYS_INLINE int pointLightsCount() const { return static_cast<int>(mPointLights.size()); }
+
+        void flush(const Camera &camera);
     private:
         std::unique_ptr<gpu::SharedUniformBuffer> mBuffer;
-        std::unique_ptr<gpu::BufferLayout> mLayout;
+        std::unique_ptr<LightClusters> mClusters;
+        LightsBlock mBlock {};
+        std::vector<PointLight> mPointLights;
 
-        int mDirLightsCount;
-        std::vector<DirLight> mDirLights;
+        uint32_t mDirtyBegin { sizeof(LightsBlock) };
+        uint32_t mDirtyEnd { 0 };
 
-        int mPointLightsCount;
-        std::vector<PointLight> mPointLights;
+        void markDirty(const void *member, uint32_t size);
     };
 
 }
@@ -0,0 +1,204 @@
+#include "light_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include "engine/engine.h"
+#include "light.h"
+#include "shader.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace gfx {
+    LightClusters::LightClusters()
+        : mClusterLights(ClusterCount * MaxLightsPerCluster)
+        , mRanges(ClusterCount * 2)
+    {
+        mLightData = gpu::TextureBuffer::create(gpu::TextureBufferFormat::Rgba32F);
+        mClusterRanges = gpu::TextureBuffer::create(gpu::TextureBufferFormat::Rg32UI);
+        mClusterIndices = gpu::TextureBuffer::create(gpu::TextureBufferFormat::R16UI);
+
+        // Exponential slices keep clusters roughly cube shaped over the whole depth range
+        for (uint32_t i = 0; i <= GridZ; i++) {
+            mSliceDepths[i] = Camera::NearPlane * std::pow(Camera::FarPlane / Camera::NearPlane, float(i) / float(GridZ));
+        }
+    }
+
+    void LightClusters::update(const Camera &camera, const std::vector<PointLight> &lights) {
+        auto lightCount = lights.size();
+        auto paddedCount = (lightCount + 3) & ~std::size_t { 3 };
+
+        mLightX.assign(paddedCount, 0.0f);
+        mLightY.assign(paddedCount, 0.0f);
+        // Padding lights sit behind the camera so they never overlap a slice
+        mLightDepth.assign(paddedCount, -1.0f);
+        mLightRadius.assign(paddedCount, 0.0f);
+        mLightTexels.resize(lightCount * 4);
+
+        const auto &view = camera.view();
+        for (std::size_t i = 0; i < lightCount; i++) {
+            const auto &light = lights[i];
+            auto radius = pointLightRange(light);
+            auto viewPosition = view * glm::vec4(light.position, 1.0f);
+
+            mLightX[i] = viewPosition.x;
+            mLightY[i] = viewPosition.y;
+            mLightDepth[i] = -viewPosition.z;
+            mLightRadius[i] = radius;
+
+            mLightTexels[i * 4] = glm::vec4(light.position, radius);
+            mLightTexels[i * 4 + 1] = glm::vec4(light.ambient, light.constant);
+            mLightTexels[i * 4 + 2] = glm::vec4(light.diffuse, light.linear);
+            mLightTexels[i * 4 + 3] = glm::vec4(light.specular, light.quadratic);
+        }
+
+        mClusterCounts.fill(0);
+
+        // Every slice writes to its own clusters only, so slices are binned in parallel
+        const auto &projection = camera.projection();
+        const auto &size = camera.size();
+        Engine::instance().jobSystem().parallelFor(GridZ, 1, [&](std::size_t begin, std::size_t end) {
+            for (auto slice = begin; slice < end; slice++) {
+                assignSlice(static_cast<uint32_t>(slice), paddedCount, projection, size);
+            }
+        });
+
+        mIndices.clear();
+        for (uint32_t cluster = 0; cluster < ClusterCount; cluster++) {
+            auto count = mClusterCounts[cluster];
+            auto first = mClusterLights.begin() + cluster * MaxLightsPerCluster;
+
+            mRanges[cluster * 2] = static_cast<uint32_t>(mIndices.size());
+            mRanges[cluster * 2 + 1] = count;
+            mIndices.insert(mIndices.end(), first, first + count);
+        }
+
+        mLightData->setData(mLightTexels.data(), mLightTexels.size() * sizeof(glm::vec4));
+        mClusterRanges->setData(mRanges.data(), mRanges.size() * sizeof(uint32_t));
+        mClusterIndices->setData(mIndices.data(), mIndices.size() * sizeof(uint16_t));
+    }
+
+    void LightClusters::bind() const {
+        mLightData->bind(PointLightDataUnit);
+        mClusterRanges->bind(ClusterRangesUnit);
+        mClusterIndices->bind(ClusterLightsUnit);
+    }
+
+    glm::vec4 LightClusters::gridParams(const Camera &camera) const {
+        auto depthRange = std::log(Camera::FarPlane / Camera::NearPlane);
+
+        return {
+            std::ceil(float(camera.size().width()) / float(GridX)),
+            std::ceil(float(camera.size().height()) / float(GridY)),
+            float(GridZ) / depthRange,
+            -float(GridZ) * std::log(Camera::NearPlane) / depthRange,
+        };
+    }
+
+    void LightClusters::assignSlice(uint32_t slice, std::size_t lightCount, const glm::mat4 &projection,
+                                    const math::Size2D &size) {
+        auto sliceNear = mSliceDepths[slice];
+        auto sliceFar = mSliceDepths[slice + 1];
+
+        auto tileWidth = std::ceil(float(size.width()) / float(GridX));
+        auto tileHeight = std::ceil(float(size.height()) / float(GridY));
+
+        auto tile = [](float ndc, int pixels, float tileSize, uint32_t tiles) {
+            auto index = static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * float(pixels) / tileSize));
+            return static_cast<uint32_t>(std::clamp(index, 0, static_cast<int>(tiles) - 1));
+        };
+
+        auto assign = [&](std::size_t light) {
+            auto x = mLightX[light];
+            auto y = mLightY[light];
+            auto depth = mLightDepth[light];
+            auto radius = mLightRadius[light];
+
+            // Bounds of the light's box within the slice. x over depth is monotonic in both, so the projected
+            // extremes are found at the corners.
+            auto minDepth = std::max(sliceNear, depth - radius);
+            auto maxDepth = std::min(sliceFar, depth + radius);
+
+            auto minX = std::min((x - radius) / minDepth, (x - radius) / maxDepth) * projection[0][0];
+            auto maxX = std::max((x + radius) / minDepth, (x + radius) / maxDepth) * projection[0][0];
+            auto minY = std::min((y - radius) / minDepth, (y - radius) / maxDepth) * projection[1][1];
+            auto maxY = std::max((y + radius) / minDepth, (y + radius) / maxDepth) * projection[1][1];
+
+            if (minX > 1.0f || maxX < -1.0f || minY > 1.0f || maxY < -1.0f) {
+                return;
+            }
+
+            auto firstX = tile(minX, size.width(), tileWidth, GridX);
+            auto lastX = tile(maxX, size.width(), tileWidth, GridX);
+            auto firstY = tile(minY, size.height(), tileHeight, GridY);
+            auto lastY = tile(maxY, size.height(), tileHeight, GridY);
+
+            for (auto tileY = firstY; tileY <= lastY; tileY++) {
+                for (auto tileX = firstX; tileX <= lastX; tileX++) {
+                    addToCluster(tileX + GridX * (tileY + GridY * slice), static_cast<uint16_t>(light));
+                }
+            }
+        };
+
+#ifdef __SSE2__
+        auto nearDepth = _mm_set1_ps(sliceNear);
+        auto farDepth = _mm_set1_ps(sliceFar);
+
+        for (std::size_t i = 0; i < lightCount; i += 4) {
+            auto depth = _mm_loadu_ps(&mLightDepth[i]);
+            auto radius = _mm_loadu_ps(&mLightRadius[i]);
+
+            auto overlaps = _mm_and_ps(_mm_cmplt_ps(_mm_sub_ps(depth, radius), farDepth),
+                                       _mm_cmpgt_ps(_mm_add_ps(depth, radius), nearDepth));
+
+            auto mask = _mm_movemask_ps(overlaps);
+            while (mask != 0) {
+                assign(i + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+#else
+        for (std::size_t i = 0; i < lightCount; i++) {
+            if (mLightDepth[i] - mLightRadius[i] < sliceFar && mLightDepth[i] + mLightRadius[i] > sliceNear) {
+                assign(i);
+            }
+        }
+#endif
+    }
+
+    void LightClusters::addToCluster(uint32_t cluster, uint16_t light) {
+        auto &count = mClusterCounts[cluster];
+        if (count == MaxLightsPerCluster) {
+            return;
+        }
+
+        mClusterLights[cluster * MaxLightsPerCluster + count] = light;
+        count++;
+    }
+
+    float pointLightRange(const PointLight &light) {
+        // Attenuated below one step of an 8 bit channel
+        constexpr float Cutoff = 256.0f;
+
+        auto intensity = std::max({ light.ambient.x, light.ambient.y, light.ambient.z,
+                                    light.diffuse.x, light.diffuse.y, light.diffuse.z });
+
+        // Solves 1 / (constant + linear * d + quadratic * d^2) = 1 / (intensity * cutoff) for d
+        auto c = light.constant - intensity * Cutoff;
+        if (c >= 0.0f) {
+            return 0.0f;
+        }
+
+        float range;
+        if (light.quadratic > 0.0f) {
+            range = (-light.linear + std::sqrt(light.linear * light.linear - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic);
+        } else if (light.linear > 0.0f) {
+            range = -c / light.linear;
+        } else {
+            range = Camera::FarPlane;
+        }
+
+        return std::max(range, 0.0f);
+    }
+}
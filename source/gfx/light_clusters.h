@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "gpu/gpu.h"
+#include "camera.h"
+
+namespace gfx {
+    struct PointLight;
+
+    // Splits the view frustum in screen tiles and exponential depth slices, and lists per cluster the point lights whose
+    // range reaches into it. The fragment shader looks up its cluster and only evaluates those lights.
+    class LightClusters {
+    public:
+        static constexpr uint32_t GridX = 16;
+        static constexpr uint32_t GridY = 9;
+        static constexpr uint32_t GridZ = 24;
+        static constexpr uint32_t ClusterCount = GridX * GridY * GridZ;
+        static constexpr uint32_t MaxLightsPerCluster = 128;
+
+        LightClusters();
+
+        // Bins the lights and uploads the light data, cluster ranges and light indices
+        void update(const Camera &camera, const std::vector<PointLight> &lights);
+
+        void bind() const;
+
+        // Values the shader needs to find the cluster of a fragment, stored in the Lights block
+        [[nodiscard]] glm::uvec4 gridSize() const { return { GridX, GridY, GridZ, 0 }; }
+        [[nodiscard]] glm::vec4 gridParams(const Camera &camera) const;
+    private:
+        std::unique_ptr<gpu::TextureBuffer> mLightData;
+        std::unique_ptr<gpu::TextureBuffer> mClusterRanges;
+        std::unique_ptr<gpu::TextureBuffer> mClusterIndices;
+
+        std::array<float, GridZ + 1> mSliceDepths {};
+
+        // View space bounds of every light as separate arrays, padded to a multiple of four for the SSE loop
+        std::vector<float> mLightX;
+        std::vector<float> mLightY;
+        std::vector<float> mLightDepth;
+        std::vector<float> mLightRadius;
+
+        std::vector<glm::vec4> mLightTexels;
+        std::vector<uint16_t> mClusterLights;
+        std::array<uint32_t, ClusterCount> mClusterCounts {};
+        std::vector<uint32_t> mRanges;
+        std::vector<uint16_t> mIndices;
+
+        void assignSlice(uint32_t slice, std::size_t lightCount, const glm::mat4 &projection, const math::Size2D &size);
+        void addToCluster(uint32_t cluster, uint16_t light);
+    };
+
+    // Distance at which the light's attenuation makes it fall below what a display can show
+    float pointLightRange(const PointLight &light);
+}
@@ -1,11 +1,17 @@
 #include "material.h"
 
+#include <stdexcept>
+
 namespace gfx {
     void Material::setShader(ShaderHandle shader) {
         mShader = shader;
     }
 
     void Material::addTexture(TextureHandle texture) {
+        if (mTextures.size() >= MaxMaterialTextures) {
+            throw std::runtime_error("Material has more textures than texture units");
+        }
+
         mTextures.push(texture);
     }
 }
\ No newline at end of file
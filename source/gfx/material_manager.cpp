@@ -18,6 +18,10 @@ namespace gfx {
         static int addTexture(lua_State *L) {
             auto material = getMaterial(L);
             auto texturePath = lua::checkArg<const char*>(L, 1);
+            if (material->textures().size() >= MaxMaterialTextures) {
+                return luaL_error(L, "A material takes at most %d textures", MaxMaterialTextures);
+            }
+
             auto texture = TextureManager::instance().createTexture(Path { texturePath });
             material->addTexture(texture);
 
@@ -39,7 +43,7 @@ namespace gfx {
             static lua_State* L { nullptr };
 
             if (L == nullptr) {
-                L = luaL_newstate();
+                L = lua::newState();
                 luaL_openlibs(L);
 
                 lua_pushcfunction(L, luaApi::setShader);
@@ -54,11 +58,11 @@ namespace gfx {
     }
 
     MaterialHandle MaterialManager::createMaterial(const Path &path) {
-        if (mMaterialPathsIdsMap.contains(path)) {
-            return MaterialHandle { mMaterialPathsIdsMap[path] };
+        if (auto handle = find(path.hash())) {
+            return *handle;
         }
 
-        auto material = std::make_unique<Material>(Engine::instance().allocator());
+        auto material = mMaterialPool.create(Engine::instance().allocator(MemoryTag::Gfx));
 
         FileReader fileReader { path.value() };
         auto fileContent = fileReader.getFileContent();
@@ -67,20 +71,30 @@ namespace gfx {
         auto L = lua_newthread(root_state);
         const auto state_ref = luaL_ref(root_state, LUA_REGISTRYINDEX);
 
-        lua_pushlightuserdata(L, material.get());
+        lua_pushlightuserdata(L, material);
         lua_setglobal(L, "this");
 
         lua::execute(luaApi::getMaterialState(), fileContent, path.value(), 0);
 
         luaL_unref(root_state, LUA_REGISTRYINDEX, state_ref);
 
-        mMaterialPathsIdsMap.try_emplace(path, mNextId);
-        mMaterials.insert({ mNextId, std::move(material) });
+        mMaterialPathsIdsMap.insert(path.hash(), mNextId);
+        mMaterials.insert(mNextId, material);
 
         return MaterialHandle { mNextId++ };
     }
 
+    std::optional<MaterialHandle> MaterialManager::find(Hash64 pathHash) {
+        auto it = mMaterialPathsIdsMap.find(pathHash);
+        if (it == mMaterialPathsIdsMap.end()) {
+            return std::nullopt;
+        }
+
+        return MaterialHandle { *it };
+    }
+
     Material* MaterialManager::get(uint32_t id) {
-        return mMaterials[id].get();
+        auto it = mMaterials.find(id);
+        return it == mMaterials.end() ? nullptr : *it;
     }
 }
\ No newline at end of file
@@ -1,9 +1,13 @@
 #pragma once
 
-#include <unordered_map>
+#include <optional>
+#include <string_view>
 #include <memory>
 #include "engine/path.h"
 #include "engine/resource.h"
+#include "engine/engine.h"
+#include "engine/map.h"
+#include "engine/pool_allocator.h"
 #include "material.h"
 
 namespace gfx {
@@ -16,7 +20,15 @@ namespace gfx {
 
         MaterialHandle createMaterial(const Path &path);
 
+        // Lookups by hash or path string, the path is hashed in place so no Path or std::string is built
+        std::optional<MaterialHandle> find(Hash64 pathHash);
+        std::optional<MaterialHandle> find(std::string_view path) { return find(Hash64(path)); }
+
         void cleanup() {
+            for (auto material : mMaterials) {
+                mMaterialPool.destroy(material);
+            }
+
             mMaterialPathsIdsMap.clear();
             mMaterials.clear();
         }
@@ -28,8 +40,9 @@ namespace gfx {
 
         Material* get(uint32_t id);
 
-        std::unordered_map<Path, uint32_t> mMaterialPathsIdsMap;
-        std::unordered_map<uint32_t, std::unique_ptr<Material>> mMaterials;
+        HashMap<Hash64, uint32_t> mMaterialPathsIdsMap { Engine::instance().allocator(MemoryTag::Gfx) };
+        HashMap<uint32_t, Material*> mMaterials { Engine::instance().allocator(MemoryTag::Gfx) };
+        PoolAllocator<Material> mMaterialPool { Engine::instance().allocator(MemoryTag::Gfx), 16 };
 
         uint32_t mNextId { 0 };
     };
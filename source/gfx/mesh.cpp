@@ -9,8 +9,26 @@ namespace gfx {
         mVertexBuffer = gpu::VertexBuffer::create(vertices, size, Vertex::layout);
     }
 
-    void Mesh::draw() const {
+    Mesh::Mesh(const Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount) {
+        mVertexBuffer = gpu::VertexBuffer::create(vertices, vertexCount * sizeof(Vertex), Vertex::layout, indices, indexCount);
+    }
+
+    void Mesh::bind() const {
         mVertexBuffer->bind();
+    }
+
+    void Mesh::draw() const {
         mVertexBuffer->draw();
     }
+
+    void Mesh::drawInstanced(const gpu::StreamBuffer &instances, const gpu::VertexLayout &instanceLayout,
+                             uint32_t instanceOffset, uint32_t instanceCount) const {
+        mVertexBuffer->drawInstanced(instances, instanceLayout, instanceOffset, instanceCount);
+    }
+
+    void remapTexCoords(Vertex *vertices, size_t count, const glm::vec4 &uvRect) {
+        for (size_t i = 0; i < count; i++) {
+            vertices[i].texCoords = remapTexCoords(vertices[i].texCoords, uvRect);
+        }
+    }
 }
\ No newline at end of file
@@ -33,11 +33,25 @@ namespace gfx {
         static inline bool initialized = false;
     };
 
+    // Maps texture coordinates spanning a whole texture into a rect of it, such as an entry of a texture atlas. The
+    // rect holds the start corner in x y and the end corner in z w.
+    [[nodiscard]] inline glm::vec2 remapTexCoords(const glm::vec2 &texCoords, const glm::vec4 &uvRect) {
+        return glm::vec2(uvRect.x, uvRect.y) + texCoords * glm::vec2(uvRect.z - uvRect.x, uvRect.w - uvRect.y);
+    }
+
+    void remapTexCoords(Vertex *vertices, size_t count, const glm::vec4 &uvRect);
+
     class Mesh : public Resource<MeshManager> {
     public:
         explicit Mesh(const std::vector<Vertex> &vertices);
         Mesh(Vertex *vertices, size_t size);
+        Mesh(const Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount);
+
+        void bind() const;
+        // Draws with the vertex buffer bound by the last bind call
         void draw() const;
+        void drawInstanced(const gpu::StreamBuffer &instances, const gpu::VertexLayout &instanceLayout, uint32_t instanceOffset,
+                           uint32_t instanceCount) const;
 
     private:
         std::unique_ptr<gpu::VertexBuffer> mVertexBuffer;
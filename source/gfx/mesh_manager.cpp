@@ -11,16 +11,51 @@ namespace gfx {
     };
 
     Mesh *MeshManager::get(uint32_t id) {
-        return mMeshes[id].get();
+        auto it = mMeshes.find(id);
+        return it == mMeshes.end() ? nullptr : *it;
     }
 
     void MeshManager::initialize() {
-        auto mesh = std::make_unique<Mesh>(planeVertices, sizeof(planeVertices));
+        auto mesh = mMeshPool.create(planeVertices, sizeof(planeVertices));
 
-        mMeshes.insert({ mNextId, std::move(mesh) });
+        mMeshes.insert(mNextId, mesh);
         mPlane = MeshHandle(mNextId++);
     }
 
+    MeshHandle MeshManager::createMesh(const std::vector<Vertex> &vertices) {
+        auto mesh = mMeshPool.create(vertices);
+
+        mMeshes.insert(mNextId, mesh);
+        return MeshHandle(mNextId++);
+    }
+
+    MeshHandle MeshManager::createMesh(const Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount) {
+        auto mesh = mMeshPool.create(vertices, vertexCount, indices, indexCount);
+
+        mMeshes.insert(mNextId, mesh);
+        return MeshHandle(mNextId++);
+    }
+
+    void MeshManager::updateMesh(MeshHandle handle, const Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount) {
+        auto it = mMeshes.find(handle.id());
+        if (it == mMeshes.end()) {
+            throw std::runtime_error("Updating unknown mesh");
+        }
+
+        mMeshPool.destroy(*it);
+        *it = mMeshPool.create(vertices, vertexCount, indices, indexCount);
+    }
+
+    void MeshManager::destroyMesh(MeshHandle handle) {
+        auto it = mMeshes.find(handle.id());
+        if (it == mMeshes.end()) {
+            return;
+        }
+
+        mMeshPool.destroy(*it);
+        mMeshes.remove(handle.id());
+    }
+
     MeshHandle MeshManager::plane() {
         return mPlane;
     }
@@ -2,6 +2,9 @@
 
 #include "mesh.h"
 #include "engine/path.h"
+#include "engine/engine.h"
+#include "engine/map.h"
+#include "engine/pool_allocator.h"
 
 namespace gfx {
     class MeshManager {
@@ -15,7 +18,18 @@ namespace gfx {
 
         MeshHandle plane();
 
+        MeshHandle createMesh(const std::vector<Vertex> &vertices);
+        MeshHandle createMesh(const Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount);
+
+        // Replaces the geometry behind the handle, for static meshes that are rebuilt now and then
+        void updateMesh(MeshHandle handle, const Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount);
+        void destroyMesh(MeshHandle handle);
+
         void cleanup() {
+            for (auto mesh : mMeshes) {
+                mMeshPool.destroy(mesh);
+            }
+
             mMeshPathIds.clear();
             mMeshes.clear();
         }
@@ -27,8 +41,9 @@ namespace gfx {
 
         Mesh* get(uint32_t id);
 
-        std::unordered_map<Path, uint32_t> mMeshPathIds;
-        std::unordered_map<uint32_t, std::unique_ptr<Mesh>> mMeshes;
+        HashMap<Hash64, uint32_t> mMeshPathIds { Engine::instance().allocator(MemoryTag::Gfx) };
+        HashMap<uint32_t, Mesh*> mMeshes { Engine::instance().allocator(MemoryTag::Gfx) };
+        PoolAllocator<Mesh> mMeshPool { Engine::instance().allocator(MemoryTag::Gfx), 16 };
 
         MeshHandle mPlane;
         uint32_t mNextId { 0 };
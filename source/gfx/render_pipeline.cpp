@@ -1,5 +1,7 @@
+#include <array>
+#include <bit>
 #include <fstream>
-#include <queue>
+#include <new>
 #include "glm/glm.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -8,6 +10,8 @@
 #include "shader_manager.h"
 #include "texture_manager.h"
 #include "material_manager.h"
+#include "mesh_manager.h"
+#include "engine/engine.h"
 
 #include "light.h"
 #include "camera.h"
@@ -26,17 +30,39 @@ namespace gfx {
         static inline gpu::VertexLayout layout;
     };
 
+    // Per instance attributes, read by the vertex shader from the location after the mesh attributes
+    struct InstanceData {
+        glm::mat4 model;
+
+        static void init() {
+            layout.addAttribute(gpu::Attribute::InstanceTransform, gpu::AttributeType::Mat4, false);
+        }
+
+        static inline gpu::VertexLayout layout;
+    };
+
+    // Mirrors the std140 Camera block, written once per frame and shared by every shader
+    struct CameraBlock {
+        glm::mat4 view;
+        glm::mat4 projection;
+    };
+
     class RenderPipelineImpl : public RenderPipeline {
     public:
         explicit RenderPipelineImpl(Allocator &allocator, math::Size2D frameDimensions)
             : mWidth(frameDimensions.width())
             , mHeight(frameDimensions.height())
             , mCamera(frameDimensions)
+            , mRenderCommands(Engine::instance().frameArena())
         {
         }
 
         void initialize() override {
             PosTextVertex::init();
+            InstanceData::init();
+
+            mInstanceStream = gpu::StreamBuffer::create(gpu::StreamTarget::Vertex, InitialInstanceCapacity * sizeof(InstanceData));
+            mUniformStream = gpu::StreamBuffer::create(gpu::StreamTarget::Uniform, UniformStreamSize);
 
             DirLight dirLight {};
             std::vector<DirLight> dirLights;
@@ -61,38 +87,128 @@ namespace gfx {
             pointLights.push_back(pointLight);
 
             mLights = Lights(dirLights, pointLights);
-            mLights.setBufferData();
         }
 
         void renderCommand(const RenderCommand &command) override {
-            mRenderCommands.push(command);
+            if (mRenderCommands.capacity() == 0) {
+                // Size for last frame's commands so the arena doesn't fill up with grown out buffers
+                mRenderCommands.reserve(mLastCommandCount);
+            }
+
+            // Runs of commands mostly share a material, only resolve its shader when it changes
+            if (command.material.id() != mLastMaterialId) {
+                mLastMaterialId = command.material.id();
+                mLastShaderId = command.material->shader().id();
+            }
+
+            auto viewPosition = mCamera.view() * glm::vec4(command.transform.position(), 1.0f);
+            auto depth = -viewPosition.z / Camera::FarPlane;
+
+            auto key = sortkey::make(RenderPass::Opaque, mLastShaderId, command.material.id(), command.mesh.id(), depth);
+            mRenderCommands.submit(command, key);
         }
 
         void renderFrame() override {
+            TextureManager::instance().update();
+
             gpu::clear();
 
-            while (!mRenderCommands.empty()) {
-                auto const &command = mRenderCommands.front();
+            // Grow the instance ring rather than fail when a frame outgrows it. The driver keeps the old buffer alive
+            // until the GPU is done with its frames.
+            auto instanceCount = static_cast<uint32_t>(mRenderCommands.size());
+            auto instanceBytes = instanceCount * static_cast<uint32_t>(sizeof(InstanceData));
+            if (instanceBytes > mInstanceStream->frameCapacity()) {
+                mInstanceStream = gpu::StreamBuffer::create(gpu::StreamTarget::Vertex, std::bit_ceil(instanceBytes));
+            }
+
+            mInstanceStream->beginFrame();
+            mUniformStream->beginFrame();
 
-                int textureHandle = 0;
-                for (auto texture : command.material->textures()) {
-                    texture->render(textureHandle++);
-                }
+            auto cameraBlock = mUniformStream->allocate(sizeof(CameraBlock), alignof(CameraBlock));
+            new (cameraBlock.data) CameraBlock { mCamera.view(), mCamera.projection() };
+            mUniformStream->commit();
+            mUniformStream->bindRange(CameraBlockBinding, cameraBlock.offset, sizeof(CameraBlock));
 
-                command.material->shader()->bind();
+            mLights.flush(mCamera);
 
-                auto model = glm::mat4(1.0f);
-                model = glm::translate(model, command.transform.position());
+            mRenderCommands.sort();
 
-                gpu::setUniform(command.material->shader()->programHandle(), "model", model);
-                gpu::setUniform(command.material->shader()->programHandle(), "view", mCamera.view());
-                gpu::setUniform(command.material->shader()->programHandle(), "projection", mCamera.projection());
-                gpu::setUniform(command.material->shader()->programHandle(), "invtransmodel", glm::inverse(glm::transpose(model)));
+            // Instance data is written straight into the mapped stream in sorted order, so every run of equal mesh
+            // and material is one contiguous range
+            auto instanceRange = mInstanceStream->allocate(instanceBytes, alignof(InstanceData));
+            auto instances = static_cast<InstanceData*>(instanceRange.data);
+            for (uint32_t i = 0; i < instanceCount; i++) {
+                new (instances + i) InstanceData { glm::translate(glm::mat4(1.0f), mRenderCommands[i].transform.position()) };
+            }
+
+            mInstanceStream->commit();
+
+            // State is only touched when it differs from the previous command, sorting groups equal state together
+            uint32_t shaderId = InvalidId;
+            uint32_t materialId = InvalidId;
+            uint32_t meshId = InvalidId;
+            const Mesh *mesh = nullptr;
+
+            // Materials sharing an atlas bind the same texture, only units holding another texture are rebound
+            std::array<uint32_t, MaxMaterialTextures> boundTextures;
+            boundTextures.fill(InvalidId);
+
+            std::size_t i = 0;
+            while (i < mRenderCommands.size()) {
+                const auto &command = mRenderCommands[i];
 
-                command.mesh->draw();
+                if (command.material.id() != materialId) {
+                    materialId = command.material.id();
+                    auto material = command.material.get();
 
-                mRenderCommands.pop();
+                    uint32_t unit = 0;
+                    for (auto texture : material->textures()) {
+                        if (boundTextures[unit] != texture.id()) {
+                            boundTextures[unit] = texture.id();
+                            texture->render(unit);
+                        }
+
+                        unit++;
+                    }
+
+                    if (material->shader().id() != shaderId) {
+                        shaderId = material->shader().id();
+                        material->shader()->bind();
+                    }
+                }
+
+                if (command.mesh.id() != meshId) {
+                    meshId = command.mesh.id();
+                    mesh = command.mesh.get();
+                    mesh->bind();
+                }
+
+                // Collapse the run of commands drawing this mesh with this material into one instanced draw
+                auto runEnd = i + 1;
+                while (runEnd < mRenderCommands.size() && mRenderCommands[runEnd].mesh.id() == meshId
+                       && mRenderCommands[runEnd].material.id() == materialId) {
+                    runEnd++;
+                }
+
+                auto instanceOffset = instanceRange.offset + static_cast<uint32_t>(i * sizeof(InstanceData));
+                mesh->drawInstanced(*mInstanceStream, InstanceData::layout, instanceOffset, runEnd - i);
+                i = runEnd;
             }
+
+            mInstanceStream->endFrame();
+            mUniformStream->endFrame();
+
+            // The commands live on the frame arena, drop them before the arena is swapped
+            mLastCommandCount = mRenderCommands.size();
+            mRenderCommands.reset();
+        }
+
+        [[nodiscard]] const Camera& camera() const override {
+            return mCamera;
+        }
+
+        Lights& lights() override {
+            return mLights;
         }
 
         void resize(math::Size2D frameDimensions) override {
@@ -110,7 +226,17 @@ namespace gfx {
 
         Camera mCamera;
 
-        std::queue<RenderCommand> mRenderCommands;
+        static constexpr uint32_t InvalidId = ~0u;
+        // Instances per frame the ring starts with, it grows for frames with more commands
+        static constexpr uint32_t InitialInstanceCapacity = 65536;
+        static constexpr uint32_t UniformStreamSize = 64 * 1024;
+
+        CommandBuffer mRenderCommands;
+        std::unique_ptr<gpu::StreamBuffer> mInstanceStream;
+        std::unique_ptr<gpu::StreamBuffer> mUniformStream;
+        std::size_t mLastCommandCount { 0 };
+        uint32_t mLastMaterialId { InvalidId };
+        uint32_t mLastShaderId { 0 };
         Lights mLights;
     };
 
@@ -5,15 +5,11 @@
 #include "render_component.h"
 #include "math/size.h"
 #include "mesh.h"
-#include "game/transform.h"
+#include "command_buffer.h"
+#include "camera.h"
+#include "light.h"
 
 namespace gfx {
-    struct RenderCommand {
-        Material *material;
-        game::Transform transform;
-        Mesh *mesh;
-    };
-
     class RenderPipeline {
     public:
         static std::unique_ptr<RenderPipeline> createInstance(Allocator &allocator, math::Size2D frameDimensions);
@@ -25,6 +21,11 @@ namespace gfx {
 
         virtual void resize(math::Size2D frameDimensions) = 0;
 
+        [[nodiscard]] virtual const Camera& camera() const = 0;
+
+        // Changes are uploaded at the start of the next frame
+        virtual Lights& lights() = 0;
+
         virtual ~RenderPipeline() = default;
     };
 }
@@ -1,4 +1,3 @@
-#include <GL/glew.h>
 #include "shader.h"
 #include "engine/logging.h"
 #include "gpu/gpu.h"
@@ -30,13 +29,42 @@ namespace gfx {
 
         mProgramHandle = gpu::createShaderProgram(vertexShader, fragmentShader, true);
 
-        // TODO move to gpu namespace
-        auto lightsBlockIndex = glGetUniformBlockIndex(mProgramHandle, "Lights");
-        glUniformBlockBinding(mProgramHandle, lightsBlockIndex, LightsBlockBinding);
+        gpu::bindUniformBlock(mProgramHandle, "Lights", LightsBlockBinding);
+        gpu::bindUniformBlock(mProgramHandle, "Camera", CameraBlockBinding);
+
+        for (const auto &uniform : gpu::activeUniforms(mProgramHandle)) {
+            mUniformLocations.insert(Hash64(uniform.name), uniform.location);
+
+            // Arrays are reported by their first element, make them reachable by the plain name too
+            std::string_view name { uniform.name };
+            if (name.ends_with("[0]")) {
+                mUniformLocations.insert(Hash64(name.substr(0, name.size() - 3)), uniform.location);
+            }
+        }
 
         bind();
+
+        constexpr std::pair<const char*, int> lightSamplers[] {
+            { "pointLightData", PointLightDataUnit },
+            { "clusterRanges", ClusterRangesUnit },
+            { "clusterLights", ClusterLightsUnit },
+        };
+
+        for (auto const &[name, unit] : lightSamplers) {
+            auto location = uniformLocation(name);
+            if (location != gpu::InvalidUniformLocation) {
+                gpu::setUniform(location, unit);
+            }
+        }
+
         for (auto const &[name, value] : mUniformLocs) {
-            gpu::setUniform(mProgramHandle, name, value);
+            auto location = uniformLocation(name);
+            if (location == gpu::InvalidUniformLocation) {
+                Logger::error("Uniform not found: {}", name);
+                continue;
+            }
+
+            gpu::setUniform(location, value);
         }
 
         mCompiled = true;
@@ -7,6 +7,8 @@
 
 #include "engine/vector.h"
 #include "engine/resource.h"
+#include "engine/map.h"
+#include "gpu/gpu.h"
 
 #include <unordered_map>
 
@@ -20,6 +22,16 @@ namespace gfx {
 
     constexpr int LightsBlockBinding = 0;
 
+    // Materials bind their textures to units 0 up to this count
+    constexpr int MaxMaterialTextures = 8;
+
+    // Texture units of the clustered lighting buffers, above the ones materials use
+    constexpr int PointLightDataUnit = 13;
+    constexpr int ClusterRangesUnit = 14;
+    constexpr int ClusterLightsUnit = 15;
+    static_assert(MaxMaterialTextures <= PointLightDataUnit);
+    constexpr int CameraBlockBinding = 1;
+
     enum class ShaderType {
         Vertex,
         Fragment
@@ -53,6 +65,7 @@ namespace gfx {
         explicit Shader(Allocator &allocator)
             : mStages(allocator)
             , mUniforms(allocator)
+            , mUniformLocations(allocator)
         {}
 
         ~Shader();
@@ -73,6 +86,16 @@ namespace gfx {
             return mUniforms;
         }
 
+        // Resolved when the shader is compiled, InvalidUniformLocation for uniforms the program doesn't use
+        [[nodiscard]] gpu::UniformLocation uniformLocation(Hash64 name) const {
+            auto location = mUniformLocations.get(name);
+            return location ? *location : gpu::InvalidUniformLocation;
+        }
+
+        [[nodiscard]] gpu::UniformLocation uniformLocation(std::string_view name) const {
+            return uniformLocation(Hash64(name));
+        }
+
         void addUniform(const Uniform &uniform);
         void addUniformLocs(const std::string &name, int loc);
     private:
@@ -81,8 +104,9 @@ namespace gfx {
         bool mCompiled { false };
         bool mDestroyShaders { true };
 
-        Vector<ShaderStage> mStages;
+        Vector<ShaderStage, 2> mStages;
         Vector<Uniform> mUniforms;
         std::unordered_map<std::string, int> mUniformLocs;
+        HashMap<Hash64, gpu::UniformLocation> mUniformLocations;
     };
 }
\ No newline at end of file
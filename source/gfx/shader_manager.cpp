@@ -26,7 +26,7 @@ namespace gfx {
             auto shaderType = std::string { lua::checkArg<const char*>(L, 1) };
             auto path = std::string { lua::checkArg<const char*>(L, 2) };
 
-            ShaderStage newStage {Engine::instance().allocator() };
+            ShaderStage newStage { Engine::instance().allocator(MemoryTag::Gfx) };
 
             static std::unordered_map<std::string, ShaderType> shaderTypeMap {
                 { "Vertex", ShaderType::Vertex },
@@ -42,12 +42,10 @@ namespace gfx {
 
             FileReader fileReader { path };
             auto fileContent = fileReader.getFileContent();
-            newStage.data.reserve(fileContent.size());
-
-            // TODO - Implement a back_inserter for new Vector type and read from stream in fileReader
-            for (const auto &c : fileContent) {
-                newStage.data.push(c);
-            }
+            // The stage source is handed to the driver as a null terminated string
+            newStage.data.reserve(fileContent.size() + 1);
+            newStage.data.append(fileContent.data(), fileContent.size());
+            newStage.data.push('\0');
 
             newStage.path = Path {path };
 
@@ -90,7 +88,7 @@ namespace gfx {
             static lua_State* L { nullptr };
 
             if (L == nullptr) {
-                L = luaL_newstate();
+                L = lua::newState();
                 luaL_openlibs(L);
 
                 lua_pushcfunction(L, luaApi::addStage);
@@ -108,11 +106,11 @@ namespace gfx {
     }
 
     ShaderHandle ShaderManager::createShader(const Path &path) {
-        if (mShaderPathsIdsMap.contains(path)) {
-            return ShaderHandle { mShaderPathsIdsMap[path] };
+        if (auto handle = find(path.hash())) {
+            return *handle;
         }
 
-        auto shader = std::make_unique<Shader>(Engine::instance().allocator());
+        auto shader = mShaderPool.create(Engine::instance().allocator(MemoryTag::Gfx));
 
         FileReader fileReader { path.value() };
         auto fileContent = fileReader.getFileContent();
@@ -121,7 +119,7 @@ namespace gfx {
         auto L = lua_newthread(root_state);
         const auto state_ref = luaL_ref(root_state, LUA_REGISTRYINDEX);
 
-        lua_pushlightuserdata(L, shader.get());
+        lua_pushlightuserdata(L, shader);
         lua_setglobal(L, "this");
 
         lua::execute(luaApi::getShaderState(), fileContent, path.value(), 0);
@@ -130,13 +128,23 @@ namespace gfx {
 
         shader->compile();
 
-        mShaderPathsIdsMap.insert({ path, mNextId });
-        mShaders.insert({ mNextId, std::move(shader) });
+        mShaderPathsIdsMap.insert(path.hash(), mNextId);
+        mShaders.insert(mNextId, shader);
 
         return ShaderHandle { mNextId++ };
     }
 
+    std::optional<ShaderHandle> ShaderManager::find(Hash64 pathHash) {
+        auto it = mShaderPathsIdsMap.find(pathHash);
+        if (it == mShaderPathsIdsMap.end()) {
+            return std::nullopt;
+        }
+
+        return ShaderHandle { *it };
+    }
+
     Shader* ShaderManager::get(uint32_t id) {
-        return mShaders[id].get();
+        auto it = mShaders.find(id);
+        return it == mShaders.end() ? nullptr : *it;
     }
 }
\ No newline at end of file
@@ -3,8 +3,12 @@
 #include "shader.h"
 #include "engine/path.h"
 #include "engine/resource.h"
+#include "engine/engine.h"
+#include "engine/map.h"
+#include "engine/pool_allocator.h"
 #include <memory>
-#include <unordered_map>
+#include <optional>
+#include <string_view>
 
 namespace gfx {
     class ShaderManager {
@@ -16,7 +20,15 @@ namespace gfx {
 
         ShaderHandle createShader(const Path &path);
 
+        // Lookups by hash or path string, the path is hashed in place so no Path or std::string is built
+        std::optional<ShaderHandle> find(Hash64 pathHash);
+        std::optional<ShaderHandle> find(std::string_view path) { return find(Hash64(path)); }
+
         void cleanup() {
+            for (auto shader : mShaders) {
+                mShaderPool.destroy(shader);
+            }
+
             mShaderPathsIdsMap.clear();
             mShaders.clear();
         }
@@ -27,8 +39,9 @@ namespace gfx {
 
         Shader* get(uint32_t id);
 
-        std::unordered_map<Path, uint32_t> mShaderPathsIdsMap;
-        std::unordered_map<uint32_t, std::unique_ptr<Shader>> mShaders;
+        HashMap<Hash64, uint32_t> mShaderPathsIdsMap { Engine::instance().allocator(MemoryTag::Gfx) };
+        HashMap<uint32_t, Shader*> mShaders { Engine::instance().allocator(MemoryTag::Gfx) };
+        PoolAllocator<Shader> mShaderPool { Engine::instance().allocator(MemoryTag::Gfx), 16 };
 
         uint32_t mNextId { 0 };
     };
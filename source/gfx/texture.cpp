@@ -1,31 +1,102 @@
 #include "texture.h"
-#include "math/size.h"
 
-#include "gpu/gpu.h"
+#include <cstring>
+#include "texture_cache.h"
+#include "texture_compression.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 namespace gfx {
+    static constexpr gpu::TextureFormat Formats8[] {
+        gpu::TextureFormat::R8, gpu::TextureFormat::Rg8, gpu::TextureFormat::Rgb8, gpu::TextureFormat::Rgba8
+    };
+
+    static constexpr gpu::TextureFormat Formats16[] {
+        gpu::TextureFormat::R16, gpu::TextureFormat::Rg16, gpu::TextureFormat::Rgb16, gpu::TextureFormat::Rgba16
+    };
+
+    TextureImage TextureImage::decode(const std::string &path, bool compress) {
+        if (compress) {
+            if (auto cached = loadCachedTexture(path)) {
+                return std::move(*cached);
+            }
+        }
+
+        TextureImage image;
+        int width, height, channels;
+
+        // The per thread flag, decoding runs on the job system's workers
+        stbi_set_flip_vertically_on_load_thread(true);
+
+        if (!stbi_info(path.c_str(), &width, &height, &channels)) {
+            return image;
+        }
+
+        // Block compression stores 8 bits per channel anyway, so 16 bit color images are compressed as well
+        if (compress && channels >= 3) {
+            auto pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+            if (pixels == nullptr) {
+                return image;
+            }
+
+            image.size = { width, height };
+            image.levels = mipLevelCount(image.size);
+            image.data = compressImage(pixels, image.size, image.levels, image.format);
+            stbi_image_free(pixels);
+
+            storeCachedTexture(path, image);
+            return image;
+        }
+
+        void *pixels;
+        std::size_t channelSize;
+        if (stbi_is_16_bit(path.c_str())) {
+            pixels = stbi_load_16(path.c_str(), &width, &height, &channels, 0);
+            image.format = Formats16[channels - 1];
+            channelSize = sizeof(uint16_t);
+        } else {
+            pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+            image.format = Formats8[channels - 1];
+            channelSize = sizeof(uint8_t);
+        }
+
+        if (pixels == nullptr) {
+            return image;
+        }
+
+        image.size = { width, height };
+        image.data.resize(std::size_t(width) * height * channels * channelSize);
+        std::memcpy(image.data.data(), pixels, image.data.size());
+        stbi_image_free(pixels);
+
+        return image;
+    }
+
     class TextureImpl : public Texture2D {
     public:
         ~TextureImpl() override {
-            gpu::destroyTexture(mTextureId);
+            if (mLoaded) {
+                gpu::destroyTexture(mTextureId);
+            }
         }
 
-        explicit TextureImpl(const std::string &path) {
-            int width, height, channels;
-
-            stbi_set_flip_vertically_on_load(true);
-            auto data = stbi_load_16(path.c_str(), &width, &height, &channels, 0);
+        explicit TextureImpl(gpu::TextureHandle placeholder)
+            : mTextureId(placeholder)
+        {
+        }
 
-            if (!data) {
-                throw std::runtime_error("Failed to load texture");
+        void upload(const TextureImage &image) override {
+            if (mLoaded) {
+                gpu::destroyTexture(mTextureId);
             }
 
-            mTextureId = gpu::createTexture2D(data, { width, height }, 0, [](auto imageData) {
-                stbi_image_free(imageData);
-            });
+            mTextureId = gpu::createTexture2D(image.format, image.size, image.levels, image.data.data());
+            mLoaded = true;
+        }
+
+        [[nodiscard]] bool loaded() const override {
+            return mLoaded;
         }
 
         void render(uint32_t uniformHandle) override {
@@ -33,10 +104,15 @@ namespace gfx {
         }
 
     private:
-        uint32_t mTextureId;
+        gpu::TextureHandle mTextureId;
+        bool mLoaded { false };
     };
 
-    std::unique_ptr<Texture2D> Texture2D::loadFromFile(const std::string &path) {
-        return std::make_unique<TextureImpl>(path);
+    Texture2D* Texture2D::create(PoolAllocator<Texture2D> &pool, gpu::TextureHandle placeholder) {
+        return pool.create<TextureImpl>(placeholder);
+    }
+
+    std::size_t Texture2D::instanceSize() {
+        return sizeof(TextureImpl);
     }
 }
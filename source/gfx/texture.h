@@ -1,9 +1,14 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "engine/resource.h"
+#include "engine/pool_allocator.h"
+#include "gpu/gpu.h"
+#include "math/size.h"
 
 namespace gfx {
     class Texture2D;
@@ -11,11 +16,36 @@ namespace gfx {
 
     using TextureHandle = Handle<Texture2D>;
 
+    // Decoded pixels waiting to be uploaded, decoding is safe on any thread
+    struct TextureImage {
+        gpu::TextureFormat format { gpu::TextureFormat::Rgba8 };
+        math::Size2D size { 0, 0 };
+        // Mip levels stored one after another in data
+        uint32_t levels { 1 };
+        std::vector<std::byte> data;
+
+        // Keeps the file's bit depth and channel count. With compress set, 8 bit color images are block compressed
+        // with their mip chain and cached on disk. Leaves data empty when the file can't be decoded.
+        static TextureImage decode(const std::string &path, bool compress);
+
+        [[nodiscard]] bool empty() const { return data.empty(); }
+        [[nodiscard]] std::size_t byteSize() const { return data.size(); }
+    };
+
     class Texture2D : public Resource<TextureManager> {
     public:
         virtual ~Texture2D() = default;
 
-        static std::unique_ptr<Texture2D> loadFromFile(const std::string& path);
+        // Renders with the placeholder until an image is uploaded
+        static Texture2D* create(PoolAllocator<Texture2D> &pool, gpu::TextureHandle placeholder);
+
+        // Size of the implementation, pools holding textures need slots of at least this size
+        static std::size_t instanceSize();
+
+        virtual void upload(const TextureImage &image) = 0;
+
+        [[nodiscard]] virtual bool loaded() const = 0;
+
         virtual void render(uint32_t uniformHandle) = 0;
     };
-}
\ No newline at end of file
+}
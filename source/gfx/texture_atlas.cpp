@@ -0,0 +1,132 @@
+#include "texture_atlas.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include "atlas_packer.h"
+#include "texture_compression.h"
+#include "texture_manager.h"
+
+#include <stb_image.h>
+
+namespace gfx {
+    std::optional<glm::vec4> TextureAtlas::uvRect(Hash64 name) const {
+        if (auto rect = mUvRects.get(name)) {
+            return *rect;
+        }
+
+        return std::nullopt;
+    }
+
+    TextureAtlasBuilder::TextureAtlasBuilder(int padding)
+        : mPadding(padding)
+    {
+    }
+
+    bool TextureAtlasBuilder::add(const std::string &path) {
+        int width, height, channels;
+
+        // Rows bottom up like every other texture
+        stbi_set_flip_vertically_on_load_thread(true);
+        auto pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+        if (pixels == nullptr) {
+            return false;
+        }
+
+        add(Hash64(path), pixels, { width, height });
+        stbi_image_free(pixels);
+
+        return true;
+    }
+
+    void TextureAtlasBuilder::add(Hash64 name, const uint8_t *rgba, math::Size2D size) {
+        mImages.push_back({ name, size, std::vector<uint8_t>(rgba, rgba + std::size_t(size.width()) * size.height() * 4) });
+    }
+
+    TextureAtlas TextureAtlasBuilder::build(const Path &name) const {
+        auto slotSize = [&](const Image &image) {
+            auto align = [](int value) { return (value + 3) & ~3; };
+            return math::Size2D { align(image.size.width() + mPadding * 2), align(image.size.height() + mPadding * 2) };
+        };
+
+        // Tallest first keeps the skyline flat
+        std::vector<std::size_t> order(mImages.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](auto a, auto b) {
+            return mImages[a].size.height() > mImages[b].size.height();
+        });
+
+        long area = 0;
+        for (const auto &image : mImages) {
+            auto slot = slotSize(image);
+            area += long(slot.width()) * slot.height();
+        }
+
+        auto side = static_cast<int>(std::bit_ceil(static_cast<uint32_t>(std::ceil(std::sqrt(double(area))))));
+        std::vector<glm::ivec2> positions(mImages.size());
+
+        for (;; side *= 2) {
+            if (side > MaxSize) {
+                throw std::runtime_error("Images don't fit in a texture atlas");
+            }
+
+            SkylinePacker packer { { side, side } };
+            bool packed = true;
+            for (auto index : order) {
+                auto position = packer.insert(slotSize(mImages[index]));
+                if (!position) {
+                    packed = false;
+                    break;
+                }
+
+                positions[index] = *position;
+            }
+
+            if (packed) {
+                break;
+            }
+        }
+
+        std::vector<uint8_t> texels(std::size_t(side) * side * 4);
+        TextureAtlas atlas { {}, { side, side } };
+
+        for (std::size_t i = 0; i < mImages.size(); i++) {
+            const auto &image = mImages[i];
+            auto slot = slotSize(image);
+            auto position = positions[i];
+
+            // Fill the whole slot, the border clamps to the nearest edge texel of the image
+            for (int y = 0; y < slot.height(); y++) {
+                auto sourceY = std::clamp(y - mPadding, 0, image.size.height() - 1);
+                for (int x = 0; x < slot.width(); x++) {
+                    auto sourceX = std::clamp(x - mPadding, 0, image.size.width() - 1);
+                    std::memcpy(&texels[((position.y + y) * std::size_t(side) + position.x + x) * 4],
+                                &image.texels[(sourceY * std::size_t(image.size.width()) + sourceX) * 4], 4);
+                }
+            }
+
+            auto start = glm::vec2(position.x + mPadding, position.y + mPadding) / float(side);
+            auto end = glm::vec2(position.x + mPadding + image.size.width(), position.y + mPadding + image.size.height()) / float(side);
+            atlas.mUvRects.insert(image.name, glm::vec4(start.x, start.y, end.x, end.y));
+        }
+
+        // Stop at the level where the border shrinks to a single texel
+        TextureImage image;
+        image.size = atlas.mSize;
+        image.levels = std::min(mipLevelCount(image.size), static_cast<uint32_t>(std::bit_width(static_cast<uint32_t>(mPadding))));
+
+        if (gpu::textureFormatSupported(gpu::TextureFormat::Bc1)) {
+            image.data = compressImage(texels.data(), image.size, image.levels, image.format);
+        } else {
+            image.format = gpu::TextureFormat::Rgba8;
+            image.data = generateMipChain(texels.data(), image.size, image.levels);
+        }
+
+        atlas.mTexture = TextureManager::instance().addTexture(name, image);
+
+        return atlas;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glm/glm.hpp>
+#include "engine/engine.h"
+#include "engine/hash.h"
+#include "engine/map.h"
+#include "engine/path.h"
+#include "math/size.h"
+#include "texture.h"
+
+namespace gfx {
+    // One texture holding many images, so everything drawn from it shares a single texture bind
+    class TextureAtlas {
+    public:
+        TextureAtlas(TextureHandle texture, math::Size2D size)
+            : mTexture(texture)
+            , mSize(size)
+        {
+        }
+
+        [[nodiscard]] TextureHandle texture() const { return mTexture; }
+        [[nodiscard]] const math::Size2D& size() const { return mSize; }
+
+        // Normalized start and end corner of the image, as taken by gfx::remapTexCoords
+        [[nodiscard]] std::optional<glm::vec4> uvRect(Hash64 name) const;
+        [[nodiscard]] std::optional<glm::vec4> uvRect(std::string_view name) const { return uvRect(Hash64(name)); }
+    private:
+        friend class TextureAtlasBuilder;
+
+        TextureHandle mTexture;
+        math::Size2D mSize;
+        HashMap<Hash64, glm::vec4> mUvRects { Engine::instance().allocator(MemoryTag::Gfx) };
+    };
+
+    // Collects images and packs them into a TextureAtlas. Every image is surrounded by a border repeating its edge
+    // texels and starts on a 4 texel boundary, so neither filtering, the first mip levels nor block compression mix
+    // in texels of a neighbour.
+    class TextureAtlasBuilder {
+    public:
+        static constexpr int DefaultPadding = 4;
+        static constexpr int MaxSize = 4096;
+
+        explicit TextureAtlasBuilder(int padding = DefaultPadding);
+
+        // Adds the image under its path, returns false when it can't be decoded
+        bool add(const std::string &path);
+        void add(Hash64 name, const uint8_t *rgba, math::Size2D size);
+
+        // Packs into the smallest power of two square that fits and registers the texture with the TextureManager
+        // under name, so materials can use it by that path. Throws when the images don't fit in MaxSize.
+        TextureAtlas build(const Path &name) const;
+    private:
+        struct Image {
+            Hash64 name;
+            math::Size2D size;
+            std::vector<uint8_t> texels;
+        };
+
+        int mPadding;
+        std::vector<Image> mImages;
+    };
+}
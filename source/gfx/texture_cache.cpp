@@ -0,0 +1,148 @@
+#include "texture_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "engine/hash.h"
+#include "texture_compression.h"
+
+namespace gfx {
+    static constexpr char CacheDirectory[] = "cache/textures";
+
+    // Bump when the file layout or the encoder output changes
+    static constexpr uint32_t CacheVersion = 1;
+
+    struct CacheHeader {
+        std::array<char, 4> magic;
+        uint32_t version;
+        uint32_t format;
+        int32_t width;
+        int32_t height;
+        uint32_t levels;
+        uint64_t dataSize;
+    };
+
+    static constexpr std::array<char, 4> CacheMagic { 'A', 'D', 'T', 'X' };
+
+    static std::optional<std::filesystem::path> cachePath(const std::string &path) {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        if (error) {
+            return std::nullopt;
+        }
+
+        auto modified = std::filesystem::last_write_time(path, error);
+        if (error) {
+            return std::nullopt;
+        }
+
+        auto key = path + '|' + std::to_string(size) + '|' + std::to_string(modified.time_since_epoch().count());
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.tex", static_cast<unsigned long long>(Hash64(key).value()));
+
+        return std::filesystem::path(CacheDirectory) / name;
+    }
+
+    // Byte size of the mip chain the header describes, nothing when the header can't describe a valid image
+    static std::optional<uint64_t> expectedDataSize(const CacheHeader &header) {
+        if (header.format > static_cast<uint32_t>(gpu::TextureFormat::Bc3) || header.width <= 0 || header.height <= 0) {
+            return std::nullopt;
+        }
+
+        math::Size2D size { header.width, header.height };
+        if (header.levels == 0 || header.levels > mipLevelCount(size)) {
+            return std::nullopt;
+        }
+
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < header.levels; i++) {
+            total += gpu::textureLevelSize(static_cast<gpu::TextureFormat>(header.format), size);
+            size = { std::max(size.width() / 2, 1), std::max(size.height() / 2, 1) };
+        }
+
+        return total;
+    }
+
+    std::optional<TextureImage> loadCachedTexture(const std::string &path) {
+        auto file = cachePath(path);
+        if (!file) {
+            return std::nullopt;
+        }
+
+        std::ifstream stream { *file, std::ios::binary };
+        if (!stream) {
+            return std::nullopt;
+        }
+
+        CacheHeader header {};
+        stream.read(reinterpret_cast<char*>(&header), sizeof(CacheHeader));
+        if (!stream || header.magic != CacheMagic || header.version != CacheVersion) {
+            return std::nullopt;
+        }
+
+        // A stale or corrupt entry is encoded again instead of being uploaded
+        std::error_code error;
+        auto fileSize = std::filesystem::file_size(*file, error);
+        auto dataSize = expectedDataSize(header);
+        if (error || !dataSize || *dataSize != header.dataSize || fileSize != sizeof(CacheHeader) + header.dataSize) {
+            return std::nullopt;
+        }
+
+        TextureImage image;
+        image.format = static_cast<gpu::TextureFormat>(header.format);
+        image.size = { header.width, header.height };
+        image.levels = header.levels;
+        image.data.resize(header.dataSize);
+
+        stream.read(reinterpret_cast<char*>(image.data.data()), static_cast<std::streamsize>(header.dataSize));
+        if (!stream) {
+            return std::nullopt;
+        }
+
+        return image;
+    }
+
+    void storeCachedTexture(const std::string &path, const TextureImage &image) {
+        auto file = cachePath(path);
+        if (!file) {
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(CacheDirectory, error);
+        if (error) {
+            return;
+        }
+
+        CacheHeader header {
+            CacheMagic,
+            CacheVersion,
+            static_cast<uint32_t>(image.format),
+            image.size.width(),
+            image.size.height(),
+            image.levels,
+            image.data.size(),
+        };
+
+        // Written next to the final name and renamed, so a reader never sees a partial file
+        auto temporary = *file;
+        temporary += ".tmp";
+
+        {
+            std::ofstream stream { temporary, std::ios::binary | std::ios::trunc };
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+            stream.write(reinterpret_cast<const char*>(image.data.data()), static_cast<std::streamsize>(image.data.size()));
+
+            if (!stream) {
+                stream.close();
+                std::filesystem::remove(temporary, error);
+                return;
+            }
+        }
+
+        std::filesystem::rename(temporary, *file, error);
+    }
+}
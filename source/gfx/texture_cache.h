@@ -0,0 +1,12 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include "texture.h"
+
+namespace gfx {
+    // Compressed textures are cached on disk, keyed by source path, file size and modification time so an edited
+    // source is encoded again. Failures only mean the texture is encoded again, they are not reported.
+    std::optional<TextureImage> loadCachedTexture(const std::string &path);
+    void storeCachedTexture(const std::string &path, const TextureImage &image);
+}
@@ -0,0 +1,264 @@
+#include "texture_compression.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace gfx {
+    static uint16_t packRgb565(const std::array<int, 3> &color) {
+        return static_cast<uint16_t>(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5
+                                     | ((color[2] * 31 + 127) / 255));
+    }
+
+    static std::array<int, 3> unpackRgb565(uint16_t color) {
+        auto r = (color >> 11) & 31;
+        auto g = (color >> 5) & 63;
+        auto b = color & 31;
+
+        return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+    }
+
+    static void writeLittleEndian(std::byte *output, uint64_t value, std::size_t bytes) {
+        for (std::size_t i = 0; i < bytes; i++) {
+            output[i] = static_cast<std::byte>(value >> (i * 8));
+        }
+    }
+
+    // The color half of BC1 and BC3, always in four color mode
+    static void encodeColorBlock(const uint8_t *texels, std::byte *output) {
+        std::array<int, 3> minColor { 255, 255, 255 };
+        std::array<int, 3> maxColor { 0, 0, 0 };
+        std::array<int, 3> mean { 0, 0, 0 };
+
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 3; c++) {
+                minColor[c] = std::min<int>(minColor[c], texels[i * 4 + c]);
+                maxColor[c] = std::max<int>(maxColor[c], texels[i * 4 + c]);
+                mean[c] += texels[i * 4 + c];
+            }
+        }
+
+        // The box diagonal from min to max only follows colors that rise together, flip green and blue when they
+        // fall as red rises
+        int covarianceRg = 0;
+        int covarianceRb = 0;
+        for (int i = 0; i < 16; i++) {
+            auto r = texels[i * 4] * 16 - mean[0];
+            covarianceRg += r * (texels[i * 4 + 1] * 16 - mean[1]);
+            covarianceRb += r * (texels[i * 4 + 2] * 16 - mean[2]);
+        }
+
+        if (covarianceRg < 0) {
+            std::swap(minColor[1], maxColor[1]);
+        }
+        if (covarianceRb < 0) {
+            std::swap(minColor[2], maxColor[2]);
+        }
+
+        // Pull the endpoints in a little, the extremes are usually outliers
+        for (int c = 0; c < 3; c++) {
+            auto inset = (maxColor[c] - minColor[c]) / 16;
+            maxColor[c] -= inset;
+            minColor[c] += inset;
+        }
+
+        auto color0 = packRgb565(maxColor);
+        auto color1 = packRgb565(minColor);
+        if (color0 < color1) {
+            std::swap(color0, color1);
+        }
+
+        auto endpoint0 = unpackRgb565(color0);
+        auto endpoint1 = unpackRgb565(color1);
+
+        std::array<std::array<int, 3>, 4> palette {};
+        for (int c = 0; c < 3; c++) {
+            palette[0][c] = endpoint0[c];
+            palette[1][c] = endpoint1[c];
+            palette[2][c] = (2 * endpoint0[c] + endpoint1[c]) / 3;
+            palette[3][c] = (endpoint0[c] + 2 * endpoint1[c]) / 3;
+        }
+
+        uint32_t indices = 0;
+        if (color0 != color1) {
+            for (int i = 0; i < 16; i++) {
+                int best = 0;
+                int bestDistance = std::numeric_limits<int>::max();
+
+                for (int p = 0; p < 4; p++) {
+                    int distance = 0;
+                    for (int c = 0; c < 3; c++) {
+                        auto difference = texels[i * 4 + c] - palette[p][c];
+                        distance += difference * difference;
+                    }
+
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+
+                indices |= static_cast<uint32_t>(best) << (i * 2);
+            }
+        }
+
+        writeLittleEndian(output, color0, 2);
+        writeLittleEndian(output + 2, color1, 2);
+        writeLittleEndian(output + 4, indices, 4);
+    }
+
+    static void encodeAlphaBlock(const uint8_t *texels, std::byte *output) {
+        int alpha0 = 0;
+        int alpha1 = 255;
+        for (int i = 0; i < 16; i++) {
+            alpha0 = std::max<int>(alpha0, texels[i * 4 + 3]);
+            alpha1 = std::min<int>(alpha1, texels[i * 4 + 3]);
+        }
+
+        // Eight value mode, alpha0 > alpha1 with six values interpolated in between
+        std::array<int, 8> palette { alpha0, alpha1 };
+        for (int i = 1; i < 7; i++) {
+            palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+        }
+
+        uint64_t indices = 0;
+        if (alpha0 != alpha1) {
+            for (int i = 0; i < 16; i++) {
+                int best = 0;
+                int bestDistance = 256;
+
+                for (int p = 0; p < 8; p++) {
+                    auto distance = std::abs(texels[i * 4 + 3] - palette[p]);
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+
+                indices |= static_cast<uint64_t>(best) << (i * 3);
+            }
+        }
+
+        output[0] = static_cast<std::byte>(alpha0);
+        output[1] = static_cast<std::byte>(alpha1);
+        writeLittleEndian(output + 2, indices, 6);
+    }
+
+    void encodeBc1Block(const uint8_t *texels, std::byte *output) {
+        encodeColorBlock(texels, output);
+    }
+
+    void encodeBc3Block(const uint8_t *texels, std::byte *output) {
+        encodeAlphaBlock(texels, output);
+        encodeColorBlock(texels, output + 8);
+    }
+
+    uint32_t mipLevelCount(math::Size2D size) {
+        return std::bit_width(static_cast<uint32_t>(std::max(size.width(), size.height())));
+    }
+
+    static std::vector<uint8_t> downsample(const std::vector<uint8_t> &texels, math::Size2D size, math::Size2D target) {
+        std::vector<uint8_t> result(std::size_t(target.width()) * target.height() * 4);
+
+        for (int y = 0; y < target.height(); y++) {
+            for (int x = 0; x < target.width(); x++) {
+                // Box filter over the 2x2 source texels, clamped where the source dimension is already 1
+                auto x0 = std::min(x * 2, size.width() - 1);
+                auto x1 = std::min(x * 2 + 1, size.width() - 1);
+                auto y0 = std::min(y * 2, size.height() - 1);
+                auto y1 = std::min(y * 2 + 1, size.height() - 1);
+
+                for (int c = 0; c < 4; c++) {
+                    auto sum = texels[(y0 * size.width() + x0) * 4 + c] + texels[(y0 * size.width() + x1) * 4 + c]
+                               + texels[(y1 * size.width() + x0) * 4 + c] + texels[(y1 * size.width() + x1) * 4 + c];
+                    result[(y * target.width() + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    static math::Size2D nextLevelSize(math::Size2D size) {
+        return { std::max(size.width() / 2, 1), std::max(size.height() / 2, 1) };
+    }
+
+    std::vector<std::byte> generateMipChain(const uint8_t *rgba, math::Size2D size, uint32_t levels) {
+        std::vector<uint8_t> level(rgba, rgba + std::size_t(size.width()) * size.height() * 4);
+        auto levelSize = size;
+
+        std::vector<std::byte> output;
+        for (uint32_t i = 0; i < levels; i++) {
+            if (i > 0) {
+                auto nextSize = nextLevelSize(levelSize);
+                level = downsample(level, levelSize, nextSize);
+                levelSize = nextSize;
+            }
+
+            auto bytes = reinterpret_cast<const std::byte*>(level.data());
+            output.insert(output.end(), bytes, bytes + level.size());
+        }
+
+        return output;
+    }
+
+    std::vector<std::byte> compressImage(const uint8_t *rgba, math::Size2D size, uint32_t levels, gpu::TextureFormat &format) {
+        auto texelCount = std::size_t(size.width()) * size.height();
+
+        bool opaque = true;
+        for (std::size_t i = 0; i < texelCount && opaque; i++) {
+            opaque = rgba[i * 4 + 3] == 255;
+        }
+
+        format = opaque ? gpu::TextureFormat::Bc1 : gpu::TextureFormat::Bc3;
+        auto blockSize = opaque ? 8 : 16;
+
+        std::size_t totalSize = 0;
+        for (uint32_t i = 0; i < levels; i++) {
+            auto width = std::max(size.width() >> i, 1);
+            auto height = std::max(size.height() >> i, 1);
+            totalSize += std::size_t((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+        }
+
+        std::vector<std::byte> output(totalSize);
+        auto block = output.data();
+
+        std::vector<uint8_t> level(rgba, rgba + texelCount * 4);
+        auto levelSize = size;
+
+        for (uint32_t i = 0; i < levels; i++) {
+            if (i > 0) {
+                auto nextSize = nextLevelSize(levelSize);
+                level = downsample(level, levelSize, nextSize);
+                levelSize = nextSize;
+            }
+
+            for (int blockY = 0; blockY < levelSize.height(); blockY += 4) {
+                for (int blockX = 0; blockX < levelSize.width(); blockX += 4) {
+                    // Blocks hanging over the edge repeat the last row and column
+                    std::array<uint8_t, 64> texels {};
+                    for (int y = 0; y < 4; y++) {
+                        for (int x = 0; x < 4; x++) {
+                            auto sourceX = std::min(blockX + x, levelSize.width() - 1);
+                            auto sourceY = std::min(blockY + y, levelSize.height() - 1);
+                            std::memcpy(&texels[(y * 4 + x) * 4], &level[(sourceY * levelSize.width() + sourceX) * 4], 4);
+                        }
+                    }
+
+                    if (opaque) {
+                        encodeBc1Block(texels.data(), block);
+                    } else {
+                        encodeBc3Block(texels.data(), block);
+                    }
+
+                    block += blockSize;
+                }
+            }
+        }
+
+        return output;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "gpu/gpu.h"
+#include "math/size.h"
+
+namespace gfx {
+    // Number of mip levels down to 1x1
+    uint32_t mipLevelCount(math::Size2D size);
+
+    // The first levels mip levels of an RGBA8 image, box filtered and stored one after another
+    std::vector<std::byte> generateMipChain(const uint8_t *rgba, math::Size2D size, uint32_t levels);
+
+    // Encodes the first levels mip levels of an RGBA8 image as BC1 when it is opaque and BC3 otherwise. The encoder
+    // fits endpoints to the bounding box of each block, fast enough to run on first load.
+    std::vector<std::byte> compressImage(const uint8_t *rgba, math::Size2D size, uint32_t levels, gpu::TextureFormat &format);
+
+    // Encode a single 4x4 block of RGBA8 texels, in row order
+    void encodeBc1Block(const uint8_t *texels, std::byte *output);
+    void encodeBc3Block(const uint8_t *texels, std::byte *output);
+}
@@ -0,0 +1,62 @@
+#include "texture_loader.h"
+
+#include "engine/engine.h"
+
+namespace gfx {
+    TextureLoader::TextureLoader(Allocator &allocator)
+        : mCompleted(allocator, MaxInFlight)
+    {
+    }
+
+    TextureLoader::~TextureLoader() {
+        cancel();
+    }
+
+    void TextureLoader::request(uint32_t textureId, const std::string &path, bool compress) {
+        if (mInFlight < MaxInFlight) {
+            schedule({ textureId, path, compress });
+        } else {
+            mWaiting.push_back({ textureId, path, compress });
+        }
+    }
+
+    void TextureLoader::processCompleted(std::size_t byteBudget,
+                                         const std::function<void(uint32_t, const std::string&, TextureImage&)> &upload) {
+        std::size_t uploaded = 0;
+        while (uploaded < byteBudget) {
+            auto completion = mCompleted.pop();
+            if (!completion) {
+                break;
+            }
+
+            mInFlight--;
+            uploaded += completion->image.byteSize();
+            upload(completion->textureId, completion->path, completion->image);
+        }
+
+        while (!mWaiting.empty() && mInFlight < MaxInFlight) {
+            schedule(std::move(mWaiting.front()));
+            mWaiting.pop_front();
+        }
+    }
+
+    void TextureLoader::cancel() {
+        mWaiting.clear();
+        Engine::instance().jobSystem().wait(mJobs);
+
+        while (mCompleted.pop()) {
+        }
+
+        mInFlight = 0;
+    }
+
+    void TextureLoader::schedule(Request &&request) {
+        mInFlight++;
+
+        // Background so a frame waiting on its own jobs never ends up decoding an image
+        Engine::instance().jobSystem().scheduleBackground([this, request = std::move(request)]() {
+            mCompleted.push(Completion { request.textureId, request.path,
+                                         TextureImage::decode(request.path, request.compress) });
+        }, &mJobs);
+    }
+}
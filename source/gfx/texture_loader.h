@@ -0,0 +1,57 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <string>
+#include "engine/job_system.h"
+#include "engine/queue.h"
+#include "texture.h"
+
+namespace gfx {
+    // Decodes textures on the job system and hands the results back to the GL thread. Finished images wait in a
+    // bounded queue; requests beyond its capacity are held back until the GL thread makes room.
+    class TextureLoader {
+    public:
+        static constexpr std::size_t MaxInFlight = 64;
+
+        explicit TextureLoader(Allocator &allocator);
+        ~TextureLoader();
+
+        TextureLoader(const TextureLoader&) = delete;
+        TextureLoader& operator=(const TextureLoader&) = delete;
+
+        // Block compresses color textures when compress is set, decide on the GL thread whether the GPU supports it
+        void request(uint32_t textureId, const std::string &path, bool compress);
+
+        // Calls upload for finished images on the calling thread until byteBudget is spent, an image larger than the
+        // budget still goes through on its own
+        void processCompleted(std::size_t byteBudget,
+                              const std::function<void(uint32_t textureId, const std::string &path, TextureImage &image)> &upload);
+
+        // Waits for running decodes and drops every request and result
+        void cancel();
+
+        [[nodiscard]] bool idle() const { return mInFlight == 0 && mWaiting.empty(); }
+    private:
+        struct Request {
+            uint32_t textureId;
+            std::string path;
+            bool compress;
+        };
+
+        struct Completion {
+            uint32_t textureId;
+            std::string path;
+            TextureImage image;
+        };
+
+        MpmcQueue<Completion> mCompleted;
+        std::deque<Request> mWaiting;
+
+        // Scheduled but not yet taken from the queue, never exceeds its capacity so workers can always push
+        std::size_t mInFlight { 0 };
+        JobCounter mJobs;
+
+        void schedule(Request &&request);
+    };
+}
@@ -1,19 +1,72 @@
 #include "texture_manager.h"
 
+#include "engine/logging.h"
+
 namespace gfx {
     TextureHandle TextureManager::createTexture(const Path &path) {
-        if (mTexturePathsIdsMap.contains(path)) {
-            return TextureHandle { mTexturePathsIdsMap[path] };
+        if (auto handle = find(path.hash())) {
+            return *handle;
         }
 
-        auto texture = Texture2D::loadFromFile(path.value());
-        mTexturePathsIdsMap[path] = mNextId;
-        mTextures[mNextId] = std::move(texture);
+        auto texture = Texture2D::create(mTexturePool, placeholder());
+        mTexturePathsIdsMap.insert(path.hash(), mNextId);
+        mTextures.insert(mNextId, texture);
+
+        mLoader.request(mNextId, path.value(), mCompress);
 
         return TextureHandle { mNextId++ };
     }
 
+    TextureHandle TextureManager::addTexture(const Path &path, const TextureImage &image) {
+        auto handle = find(path.hash());
+        if (!handle) {
+            mTexturePathsIdsMap.insert(path.hash(), mNextId);
+            mTextures.insert(mNextId, Texture2D::create(mTexturePool, placeholder()));
+            handle = TextureHandle { mNextId++ };
+        }
+
+        get(handle->id())->upload(image);
+
+        return *handle;
+    }
+
+    void TextureManager::update() {
+        mLoader.processCompleted(UploadBudget, [this](uint32_t id, const std::string &path, TextureImage &image) {
+            if (image.empty()) {
+                Logger::error("Failed to load texture {}", path);
+                return;
+            }
+
+            if (auto texture = get(id)) {
+                texture->upload(image);
+            }
+        });
+    }
+
+    std::optional<TextureHandle> TextureManager::find(Hash64 pathHash) {
+        auto it = mTexturePathsIdsMap.find(pathHash);
+        if (it == mTexturePathsIdsMap.end()) {
+            return std::nullopt;
+        }
+
+        return TextureHandle { *it };
+    }
+
     Texture2D *TextureManager::get(uint32_t id) {
-        return mTextures[id].get();
+        auto it = mTextures.find(id);
+        return it == mTextures.end() ? nullptr : *it;
+    }
+
+    gpu::TextureHandle TextureManager::placeholder() {
+        if (mPlaceholder == 0) {
+            // A single white texel, so a loading texture just shows its lighting
+            static const uint8_t white[] { 0xff, 0xff, 0xff, 0xff };
+            mPlaceholder = gpu::createTexture2D(gpu::TextureFormat::Rgba8, { 1, 1 }, 1, white);
+
+            // Queried here because this runs on the GL thread before the first request
+            mCompress = gpu::textureFormatSupported(gpu::TextureFormat::Bc1);
+        }
+
+        return mPlaceholder;
     }
 }
\ No newline at end of file
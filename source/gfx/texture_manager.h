@@ -1,8 +1,12 @@
 #pragma once
 
-#include <unordered_map>
+#include <optional>
+#include <string_view>
 #include "texture.h"
+#include "texture_loader.h"
 #include "engine/path.h"
+#include "engine/engine.h"
+#include "engine/map.h"
 
 namespace gfx {
     class TextureManager {
@@ -12,21 +16,53 @@ namespace gfx {
             return instance;
         }
 
+        // Returns right away, the texture renders as a placeholder until its image is decoded and uploaded
         TextureHandle createTexture(const Path &path);
 
+        // Registers an image built at runtime under path and uploads it right away, replacing the image of a texture
+        // already known by that path. Call on the GL thread.
+        TextureHandle addTexture(const Path &path, const TextureImage &image);
+
+        // Uploads decoded images within the per frame budget, call on the GL thread once per frame
+        void update();
+
+        [[nodiscard]] bool loading() const { return !mLoader.idle(); }
+
+        // Lookups by hash or path string, the path is hashed in place so no Path or std::string is built
+        std::optional<TextureHandle> find(Hash64 pathHash);
+        std::optional<TextureHandle> find(std::string_view path) { return find(Hash64(path)); }
+
         void cleanup() {
+            mLoader.cancel();
+
+            for (auto texture : mTextures) {
+                mTexturePool.destroy(texture);
+            }
+
             mTexturePathsIdsMap.clear();
             mTextures.clear();
+
+            if (mPlaceholder != 0) {
+                gpu::destroyTexture(mPlaceholder);
+                mPlaceholder = 0;
+            }
         }
     private:
         friend class Handle<Texture2D>;
 
         TextureManager() = default;
 
+        static constexpr std::size_t UploadBudget = 16 * 1024 * 1024;
+
         Texture2D* get(uint32_t id);
+        gpu::TextureHandle placeholder();
 
-        std::unordered_map<Path, uint32_t> mTexturePathsIdsMap;
-        std::unordered_map<uint32_t, std::unique_ptr<Texture2D>> mTextures;
+        HashMap<Hash64, uint32_t> mTexturePathsIdsMap { Engine::instance().allocator(MemoryTag::Gfx) };
+        HashMap<uint32_t, Texture2D*> mTextures { Engine::instance().allocator(MemoryTag::Gfx) };
+        PoolAllocator<Texture2D> mTexturePool { Engine::instance().allocator(MemoryTag::Gfx), 16, Texture2D::instanceSize() };
+        TextureLoader mLoader { Engine::instance().allocator(MemoryTag::Gfx) };
+        gpu::TextureHandle mPlaceholder { 0 };
+        bool mCompress { false };
 
         uint32_t mNextId { 0 };
     };
@@ -19,7 +19,8 @@ namespace gpu {
     enum class Attribute {
         Position,
         Normal,
-        TexCoord
+        TexCoord,
+        InstanceTransform
     };
 
     enum class AttributeType {
@@ -27,7 +28,8 @@ namespace gpu {
         Float,
         Vec2,
         Vec3,
-        Vec4
+        Vec4,
+        Mat4
     };
 
     class VertexLayout {
@@ -35,10 +37,15 @@ namespace gpu {
         VertexLayout() = default;
 
         VertexLayout& addAttribute(Attribute attribute, AttributeType type, bool normalized = false);
-        void bind() const;
+
+        // Points the attributes at the bound array buffer starting at firstLocation, a divisor of 1 steps per instance
+        void bind(uint32_t firstLocation = 0, uint32_t divisor = 0, uintptr_t baseOffset = 0) const;
+
         [[nodiscard]] constexpr int totalSize() const { return mTotalSize; }
+        [[nodiscard]] constexpr uint32_t locationCount() const { return mLocationCount; }
     private:
         int mTotalSize { 0 };
+        uint32_t mLocationCount { 0 };
 
         struct AttributeInfo {
             Attribute attribute;
@@ -51,13 +58,57 @@ namespace gpu {
         std::vector<AttributeInfo> mAttributes;
     };
 
+    enum class StreamTarget {
+        Vertex,
+        Uniform
+    };
+
+    struct StreamAllocation {
+        void *data;
+        // Offset from the start of the buffer, used to bind the data
+        uint32_t offset;
+    };
+
+    // Buffer for data written by the CPU every frame. It is split in a region per frame in flight, a frame writes to
+    // its own region and a fence keeps it from reusing a region the GPU still reads. The buffer is mapped persistently
+    // when buffer storage is available, otherwise writes are staged and copied with a single unsynchronized map.
+    class StreamBuffer {
+    public:
+        static constexpr uint32_t FramesInFlight = 3;
+
+        static std::unique_ptr<StreamBuffer> create(StreamTarget target, uint32_t frameCapacity);
+        virtual ~StreamBuffer() = default;
+
+        // Moves to the next region, waiting for the GPU when it still reads from it
+        virtual void beginFrame() = 0;
+
+        // Throws when the frame's region is full
+        virtual StreamAllocation allocate(uint32_t size, uint32_t alignment) = 0;
+
+        // Makes everything allocated so far visible to the GPU, call before drawing with it
+        virtual void commit() = 0;
+
+        virtual void endFrame() = 0;
+
+        virtual void bind() const = 0;
+        virtual void bindRange(uint32_t binding, uint32_t offset, uint32_t size) const = 0;
+
+        [[nodiscard]] virtual uint32_t frameCapacity() const = 0;
+    };
+
     class VertexBuffer {
     public:
         static std::unique_ptr<VertexBuffer> create(const void *data, uint32_t size, const VertexLayout &layout);
+        // Indexed geometry, the index buffer is captured by the vertex array and drawn with glDrawElements
+        static std::unique_ptr<VertexBuffer> create(const void *data, uint32_t size, const VertexLayout &layout,
+                                                    const uint32_t *indices, uint32_t indexCount);
         virtual ~VertexBuffer() = default;
 
         virtual void bind() const = 0;
         virtual void draw() const = 0;
+        // Reads per instance attributes laid out as instanceLayout from the stream, starting at instanceOffset
+        virtual void drawInstanced(const StreamBuffer &instances, const VertexLayout &instanceLayout, uint32_t instanceOffset,
+                                   uint32_t instanceCount) const = 0;
     };
 
     class IndexBuffer {
@@ -82,6 +133,18 @@ namespace gpu {
         uint32_t mSize;
     };
 
+    // Structs and arrays in a std140 block start on, and are padded to, a multiple of this
+    constexpr uint32_t Std140StructAlignment = 16;
+
+    constexpr uint32_t alignOffset(uint32_t offset, uint32_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    // Base alignment of a std140 scalar or vector of the given size, a vec3 is aligned like a vec4
+    constexpr uint32_t std140Alignment(uint32_t size) {
+        return size <= 4 ? 4 : size <= 8 ? 8 : 16;
+    }
+
     class BufferLayout {
     public:
         struct AttributeInfo {
@@ -103,11 +166,7 @@ namespace gpu {
             auto lastOffset = mAttributes.back().offset;
             auto lastSize = mAttributes.back().size;
 
-            auto blockRemainder = (lastOffset + lastSize) % mAlignment;
-
-            auto padding = mAlignment - blockRemainder;
-
-            return lastOffset + lastSize + padding;
+            return alignOffset(lastOffset + lastSize, mAlignment);
         }
 
         [[nodiscard]] const AttributeInfo& attribute(const std::string &name) const {
@@ -134,9 +193,35 @@ namespace gpu {
         virtual void bind() const = 0;
     };
 
+    enum class TextureBufferFormat {
+        Rgba32F,
+        Rg32UI,
+        R16UI
+    };
+
+    // Buffer read by shaders through a samplerBuffer, for arrays too large for a uniform block
+    class TextureBuffer {
+    public:
+        static std::unique_ptr<TextureBuffer> create(TextureBufferFormat format);
+        virtual ~TextureBuffer() = default;
+
+        // Replaces the whole contents, the previous storage is orphaned so the GPU can keep reading it
+        virtual void setData(const void *data, uint32_t size) = 0;
+
+        virtual void bind(int slot) const = 0;
+    };
+
     using ShaderProgramHandle = uint32_t;
     using ShaderHandle = uint32_t;
     using TextureHandle = uint32_t;
+    using UniformLocation = int32_t;
+
+    constexpr UniformLocation InvalidUniformLocation = -1;
+
+    struct ActiveUniform {
+        std::string name;
+        UniformLocation location;
+    };
 
     // SHADER
 
@@ -145,6 +230,19 @@ namespace gpu {
     void destroyShaderProgram(ShaderProgramHandle handle);
     void bindShaderProgram(ShaderProgramHandle handle);
 
+    // Uniforms of a linked program, looked up once so draws can set them by location
+    std::vector<ActiveUniform> activeUniforms(ShaderProgramHandle handle);
+    // Connects a uniform block of the program to a buffer binding point, programs without the block are skipped
+    void bindUniformBlock(ShaderProgramHandle handle, const char *blockName, uint32_t binding);
+
+    void setUniform(UniformLocation location, int value);
+    void setUniform(UniformLocation location, float value);
+    void setUniform(UniformLocation location, const glm::vec2 &value);
+    void setUniform(UniformLocation location, const glm::vec3 &value);
+    void setUniform(UniformLocation location, const glm::vec4 &value);
+    void setUniform(UniformLocation location, const glm::mat3 &value);
+    void setUniform(UniformLocation location, const glm::mat4 &value);
+
     void setUniform(ShaderProgramHandle handle, const std::string &name, int value);
     void setUniform(ShaderProgramHandle handle, const std::string &name, float value);
     void setUniform(ShaderProgramHandle handle, const std::string &name, const glm::vec2 &value);
@@ -154,7 +252,28 @@ namespace gpu {
     void setUniform(ShaderProgramHandle handle, const std::string &name, const glm::mat4 &value);
 
     // TEXTURE
-    TextureHandle createTexture2D(unsigned short *data, math::Size2D size, int flags, std::function<void(unsigned short *imageData)> cleanup);
+    enum class TextureFormat {
+        R8,
+        Rg8,
+        Rgb8,
+        Rgba8,
+        R16,
+        Rg16,
+        Rgb16,
+        Rgba16,
+        // 4x4 blocks of 8 bytes, opaque
+        Bc1,
+        // 4x4 blocks of 16 bytes, with alpha
+        Bc3
+    };
+
+    [[nodiscard]] bool isCompressed(TextureFormat format);
+    [[nodiscard]] std::size_t textureLevelSize(TextureFormat format, math::Size2D size);
+    [[nodiscard]] bool textureFormatSupported(TextureFormat format);
+
+    // data holds levels mip levels one after another, mipmaps are generated when an uncompressed texture has only
+    // one level. Single and dual channel textures read as grey and grey with alpha.
+    TextureHandle createTexture2D(TextureFormat format, math::Size2D size, uint32_t levels, const void *data);
     void destroyTexture(TextureHandle handle);
     void bindTexture(TextureHandle handle, int slot);
 
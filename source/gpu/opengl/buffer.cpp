@@ -1,5 +1,6 @@
 #include <GL/glew.h>
 
+#include <algorithm>
 #include <utility>
 #include "gpu/gpu.h"
 
@@ -25,32 +26,49 @@ namespace gpu {
                 size = sizeof(glm::vec4);
                 count = 4;
                 break;
+            case Mat4:
+                size = sizeof(glm::mat4);
+                count = 16;
+                break;
         }
 
         mTotalSize += size;
+        // Matrices take a location per column
+        mLocationCount += type == AttributeType::Mat4 ? 4 : 1;
         mAttributes.push_back({attribute, type, count, size, normalized});
 
         return *this;
     }
 
-    void VertexLayout::bind() const {
+    void VertexLayout::bind(uint32_t firstLocation, uint32_t divisor, uintptr_t baseOffset) const {
         using enum gpu::AttributeType;
 
-        uint32_t offset = 0;
-        int index = 0;
+        auto offset = baseOffset;
+        auto location = firstLocation;
         for (const auto &attribute : mAttributes) {
-            glEnableVertexAttribArray(index);
-            glVertexAttribPointer(index, attribute.count, GL_FLOAT, attribute.normalized, mTotalSize, (void*) offset);
+            auto columns = attribute.type == Mat4 ? 4u : 1u;
+            auto columnCount = attribute.count / columns;
+            auto columnSize = attribute.size / columns;
+
+            for (uint32_t column = 0; column < columns; column++) {
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(location, columnCount, GL_FLOAT, attribute.normalized, mTotalSize,
+                                      (void*) (offset + column * columnSize));
+                glVertexAttribDivisor(location, divisor);
+
+                location++;
+            }
 
             offset += attribute.size;
-            index++;
         }
     }
 
     class VertexBufferImpl : public VertexBuffer {
     public:
-        VertexBufferImpl(const void *data, uint32_t totalSize, VertexLayout layout)
+        VertexBufferImpl(const void *data, uint32_t totalSize, VertexLayout layout, const uint32_t *indices = nullptr,
+                         uint32_t indexCount = 0)
             : mVertexCount(totalSize / layout.totalSize())
+            , mIndexCount(indexCount)
             , mLayout(std::move(layout))
         {
             glGenVertexArrays(1, &mVertexArrayHandle);
@@ -62,6 +80,10 @@ namespace gpu {
             glBufferData(GL_ARRAY_BUFFER, totalSize, data, GL_STATIC_DRAW);
 
             mLayout.bind();
+
+            if (indices != nullptr) {
+                mIndexBuffer = IndexBuffer::create(indices, indexCount * sizeof(uint32_t));
+            }
         }
 
         ~VertexBufferImpl() override {
@@ -72,29 +94,40 @@ namespace gpu {
         VertexBufferImpl(const VertexBufferImpl&) = delete;
         VertexBufferImpl& operator=(const VertexBufferImpl&) = delete;
 
+        // The vertex array captured the buffer and attribute layout at creation
         void bind() const override {
             glBindVertexArray(mVertexArrayHandle);
-            glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferHandle);
-
-            mLayout.bind();
         }
 
         void draw() const override {
-            glBindVertexArray(mVertexArrayHandle);
-            glDrawArrays(GL_TRIANGLES, 0, mVertexCount);
+            if (mIndexBuffer) {
+                glDrawElements(GL_TRIANGLES, mIndexCount, GL_UNSIGNED_INT, nullptr);
+            } else {
+                glDrawArrays(GL_TRIANGLES, 0, mVertexCount);
+            }
+        }
+
+        void drawInstanced(const StreamBuffer &instances, const VertexLayout &instanceLayout, uint32_t instanceOffset,
+                           uint32_t instanceCount) const override {
+            instances.bind();
+            instanceLayout.bind(mLayout.locationCount(), 1, instanceOffset);
+
+            if (mIndexBuffer) {
+                glDrawElementsInstanced(GL_TRIANGLES, mIndexCount, GL_UNSIGNED_INT, nullptr, instanceCount);
+            } else {
+                glDrawArraysInstanced(GL_TRIANGLES, 0, mVertexCount, instanceCount);
+            }
         }
 
     private:
         uint32_t mVertexArrayHandle { 0 };
         uint32_t mVertexBufferHandle { 0 };
         uint32_t mVertexCount { 0 };
+        uint32_t mIndexCount { 0 };
         VertexLayout mLayout;
+        std::unique_ptr<IndexBuffer> mIndexBuffer;
     };
 
-    std::unique_ptr<VertexBuffer> VertexBuffer::create(const void *data, uint32_t size, const VertexLayout &layout) {
-        return std::make_unique<VertexBufferImpl>(data, size, layout);
-    }
-
     class IndexBufferImpl : public IndexBuffer {
     public:
         IndexBufferImpl(const uint32_t *data, uint32_t size)
@@ -118,6 +151,15 @@ namespace gpu {
         uint32_t mIndexBufferHandle { 0 };
     };
 
+    std::unique_ptr<VertexBuffer> VertexBuffer::create(const void *data, uint32_t size, const VertexLayout &layout) {
+        return std::make_unique<VertexBufferImpl>(data, size, layout);
+    }
+
+    std::unique_ptr<VertexBuffer> VertexBuffer::create(const void *data, uint32_t size, const VertexLayout &layout,
+                                                       const uint32_t *indices, uint32_t indexCount) {
+        return std::make_unique<VertexBufferImpl>(data, size, layout, indices, indexCount);
+    }
+
     std::unique_ptr<IndexBuffer> IndexBuffer::create(const uint32_t *data, uint32_t size) {
         return std::make_unique<IndexBufferImpl>(data, size);
     }
@@ -156,4 +198,60 @@ namespace gpu {
     std::unique_ptr<SharedUniformBuffer> SharedUniformBuffer::create(uint32_t bindingBlock, uint32_t size) {
         return std::make_unique<SharedUniformBufferImpl>(bindingBlock, size);
     }
-}
\ No newline at end of file
+
+    class TextureBufferImpl : public TextureBuffer {
+    public:
+        explicit TextureBufferImpl(TextureBufferFormat format) {
+            switch (format) {
+                using enum TextureBufferFormat;
+                case Rgba32F:
+                    mFormat = GL_RGBA32F;
+                    break;
+                case Rg32UI:
+                    mFormat = GL_RG32UI;
+                    break;
+                case R16UI:
+                    mFormat = GL_R16UI;
+                    break;
+            }
+
+            glGenBuffers(1, &mBufferHandle);
+            glGenTextures(1, &mTextureHandle);
+
+            setData(nullptr, 0);
+        }
+
+        ~TextureBufferImpl() override {
+            glDeleteTextures(1, &mTextureHandle);
+            glDeleteBuffers(1, &mBufferHandle);
+        }
+
+        void setData(const void *data, uint32_t size) override {
+            glBindBuffer(GL_TEXTURE_BUFFER, mBufferHandle);
+
+            // Never leave the texture without storage, an empty buffer texture is incomplete
+            glBufferData(GL_TEXTURE_BUFFER, std::max(size, MinSize), nullptr, GL_STREAM_DRAW);
+            if (size > 0) {
+                glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+            }
+
+            glBindTexture(GL_TEXTURE_BUFFER, mTextureHandle);
+            glTexBuffer(GL_TEXTURE_BUFFER, mFormat, mBufferHandle);
+        }
+
+        void bind(int slot) const override {
+            glActiveTexture(GL_TEXTURE0 + slot);
+            glBindTexture(GL_TEXTURE_BUFFER, mTextureHandle);
+        }
+    private:
+        static constexpr uint32_t MinSize = 16;
+
+        GLenum mFormat { GL_RGBA32F };
+        GLuint mBufferHandle { 0 };
+        GLuint mTextureHandle { 0 };
+    };
+
+    std::unique_ptr<TextureBuffer> TextureBuffer::create(TextureBufferFormat format) {
+        return std::make_unique<TextureBufferImpl>(format);
+    }
+}
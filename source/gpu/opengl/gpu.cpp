@@ -1,4 +1,5 @@
 #include <GL/glew.h>
+#include <algorithm>
 #include <glm/gtc/type_ptr.hpp>
 #include "gpu/gpu.h"
 #include "engine/logging.h"
@@ -54,59 +55,100 @@ namespace gpu {
         glUseProgram(handle);
     }
 
-    void setUniform(ShaderProgramHandle handle, const std::string &name, int value) {
-        auto uniformLocation = glGetUniformLocation(handle, name.c_str());
-        if (uniformLocation == -1) {
-            Logger::error("Uniform not found: {}", name);
+    std::vector<ActiveUniform> activeUniforms(ShaderProgramHandle handle) {
+        int uniformCount = 0;
+        glGetProgramiv(handle, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+        std::vector<ActiveUniform> result;
+        result.reserve(uniformCount);
+
+        char name[256];
+        for (int i = 0; i < uniformCount; i++) {
+            GLsizei length;
+            GLint size;
+            GLenum type;
+            glGetActiveUniform(handle, i, sizeof(name), &length, &size, &type, name);
+
+            // Members of uniform blocks have no location
+            auto location = glGetUniformLocation(handle, name);
+            if (location != InvalidUniformLocation) {
+                result.push_back({ std::string { name, static_cast<std::size_t>(length) }, location });
+            }
         }
-        glUniform1i(uniformLocation, value);
+
+        return result;
     }
 
-    void setUniform(ShaderProgramHandle handle, const std::string &name, float value) {
-        auto uniformLocation = glGetUniformLocation(handle, name.c_str());
-        if (uniformLocation == -1) {
-            Logger::error("Uniform not found: {}", name);
+    void bindUniformBlock(ShaderProgramHandle handle, const char *blockName, uint32_t binding) {
+        auto blockIndex = glGetUniformBlockIndex(handle, blockName);
+        if (blockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(handle, blockIndex, binding);
         }
-        glUniform1f(uniformLocation, value);
     }
 
-    void setUniform(ShaderProgramHandle handle, const std::string &name, const glm::vec2 &value) {
-        auto uniformLocation = glGetUniformLocation(handle, name.c_str());
-        if (uniformLocation == -1) {
+    void setUniform(UniformLocation location, int value) {
+        glUniform1i(location, value);
+    }
+
+    void setUniform(UniformLocation location, float value) {
+        glUniform1f(location, value);
+    }
+
+    void setUniform(UniformLocation location, const glm::vec2 &value) {
+        glUniform2f(location, value.x, value.y);
+    }
+
+    void setUniform(UniformLocation location, const glm::vec3 &value) {
+        glUniform3f(location, value.x, value.y, value.z);
+    }
+
+    void setUniform(UniformLocation location, const glm::vec4 &value) {
+        glUniform4f(location, value.x, value.y, value.z, value.w);
+    }
+
+    void setUniform(UniformLocation location, const glm::mat3 &value) {
+        glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+    void setUniform(UniformLocation location, const glm::mat4 &value) {
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+    static UniformLocation uniformLocation(ShaderProgramHandle handle, const std::string &name) {
+        auto location = glGetUniformLocation(handle, name.c_str());
+        if (location == InvalidUniformLocation) {
             Logger::error("Uniform not found: {}", name);
         }
-        glUniform2f(uniformLocation, value.x, value.y);
+
+        return location;
+    }
+
+    void setUniform(ShaderProgramHandle handle, const std::string &name, int value) {
+        setUniform(uniformLocation(handle, name), value);
+    }
+
+    void setUniform(ShaderProgramHandle handle, const std::string &name, float value) {
+        setUniform(uniformLocation(handle, name), value);
+    }
+
+    void setUniform(ShaderProgramHandle handle, const std::string &name, const glm::vec2 &value) {
+        setUniform(uniformLocation(handle, name), value);
     }
 
     void setUniform(ShaderProgramHandle handle, const std::string &name, const glm::vec3 &value) {
-        auto uniformLocation = glGetUniformLocation(handle, name.c_str());
-        if (uniformLocation == -1) {
-            Logger::error("Uniform not found: {}", name);
-        }
-        glUniform3f(uniformLocation, value.x, value.y, value.z);
+        setUniform(uniformLocation(handle, name), value);
     }
 
     void setUniform(ShaderProgramHandle handle, const std::string &name, const glm::vec4 &value) {
-        auto uniformLocation = glGetUniformLocation(handle, name.c_str());
-        if (uniformLocation == -1) {
-            Logger::error("Uniform not found: {}", name);
-        }
-        glUniform4f(uniformLocation, value.x, value.y, value.z, value.w);
+        setUniform(uniformLocation(handle, name), value);
     }
+
     void setUniform(ShaderProgramHandle handle, const std::string &name, const glm::mat3 &value) {
-        auto uniformLocation = glGetUniformLocation(handle, name.c_str());
-        if (uniformLocation == -1) {
-            Logger::error("Uniform not found: {}", name);
-        }
-        glUniformMatrix3fv(uniformLocation, 1, GL_FALSE, glm::value_ptr(value));
+        setUniform(uniformLocation(handle, name), value);
     }
 
     void setUniform(ShaderProgramHandle handle, const std::string &name, const glm::mat4 &value) {
-        auto uniformLocation = glGetUniformLocation(handle, name.c_str());
-        if (uniformLocation == -1) {
-            Logger::error("Uniform not found: {}", name);
-        }
-        glUniformMatrix4fv(uniformLocation, 1, GL_FALSE, glm::value_ptr(value));
+        setUniform(uniformLocation(handle, name), value);
     }
 
     void clear() {
@@ -130,21 +172,99 @@ namespace gpu {
         return true;
     }
 
-    TextureHandle createTexture2D(unsigned short *data, math::Size2D size, int flags, std::function<void(unsigned short *imageData)> cleanup) {
+    struct TextureFormatInfo {
+        GLenum internalFormat;
+        GLenum format;
+        GLenum type;
+        // Bytes per texel, or per 4x4 block for compressed formats
+        uint32_t size;
+    };
+
+    static TextureFormatInfo textureFormatInfo(TextureFormat format) {
+        switch (format) {
+            using enum TextureFormat;
+            case R8: return { GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1 };
+            case Rg8: return { GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2 };
+            case Rgb8: return { GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 3 };
+            case Rgba8: return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 };
+            case R16: return { GL_R16, GL_RED, GL_UNSIGNED_SHORT, 2 };
+            case Rg16: return { GL_RG16, GL_RG, GL_UNSIGNED_SHORT, 4 };
+            case Rgb16: return { GL_RGB16, GL_RGB, GL_UNSIGNED_SHORT, 6 };
+            case Rgba16: return { GL_RGBA16, GL_RGBA, GL_UNSIGNED_SHORT, 8 };
+            case Bc1: return { GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 0, 0, 8 };
+            case Bc3: return { GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, 0, 16 };
+        }
+
+        throw std::runtime_error("Invalid texture format");
+    }
+
+    bool isCompressed(TextureFormat format) {
+        return format == TextureFormat::Bc1 || format == TextureFormat::Bc3;
+    }
+
+    std::size_t textureLevelSize(TextureFormat format, math::Size2D size) {
+        auto info = textureFormatInfo(format);
+        if (isCompressed(format)) {
+            return std::size_t((size.width() + 3) / 4) * ((size.height() + 3) / 4) * info.size;
+        }
+
+        return std::size_t(size.width()) * size.height() * info.size;
+    }
+
+    bool textureFormatSupported(TextureFormat format) {
+        if (isCompressed(format)) {
+            return GLEW_EXT_texture_compression_s3tc;
+        }
+
+        return true;
+    }
+
+    TextureHandle createTexture2D(TextureFormat format, math::Size2D size, uint32_t levels, const void *data) {
+        auto info = textureFormatInfo(format);
+
         TextureHandle texture { 0 };
         glGenTextures(1, &texture);
         glBindTexture(GL_TEXTURE_2D, texture);
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.width(), size.height(), 0, GL_RGBA, GL_UNSIGNED_SHORT, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        // Rows of three channel and odd sized textures aren't four byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        auto level = static_cast<const std::byte*>(data);
+        auto levelSize = size;
+        for (uint32_t i = 0; i < levels; i++) {
+            auto byteSize = textureLevelSize(format, levelSize);
+
+            if (isCompressed(format)) {
+                glCompressedTexImage2D(GL_TEXTURE_2D, i, info.internalFormat, levelSize.width(), levelSize.height(), 0,
+                                       static_cast<GLsizei>(byteSize), level);
+            } else {
+                glTexImage2D(GL_TEXTURE_2D, i, info.internalFormat, levelSize.width(), levelSize.height(), 0,
+                             info.format, info.type, level);
+            }
+
+            level += byteSize;
+            levelSize = { std::max(levelSize.width() / 2, 1), std::max(levelSize.height() / 2, 1) };
+        }
+
+        if (levels == 1 && !isCompressed(format)) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        } else {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels) - 1);
+        }
+
+        if (info.format == GL_RED) {
+            GLint swizzle[] { GL_RED, GL_RED, GL_RED, GL_ONE };
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        } else if (info.format == GL_RG) {
+            GLint swizzle[] { GL_RED, GL_RED, GL_RED, GL_GREEN };
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        }
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-        cleanup(data);
-
         return texture;
     }
 
@@ -168,13 +288,7 @@ namespace gpu {
             lastSize = mAttributes.back().size;
         }
 
-        auto newOffset = lastOffset + lastSize;
-        auto blockRemainder = newOffset % mAlignment;
-
-        // Add padding to previous block
-        if (blockRemainder != 0 && blockRemainder < size) {
-            newOffset += mAlignment - blockRemainder;
-        }
+        auto newOffset = alignOffset(lastOffset + lastSize, std::min(std140Alignment(size), mAlignment));
 
         mAttributes.push_back({ name, newOffset, size });
 
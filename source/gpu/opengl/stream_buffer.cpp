@@ -0,0 +1,142 @@
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "gpu/gpu.h"
+
+namespace gpu {
+    class StreamBufferImpl : public StreamBuffer {
+    public:
+        StreamBufferImpl(StreamTarget target, uint32_t frameCapacity)
+            : mTarget(target == StreamTarget::Uniform ? GL_UNIFORM_BUFFER : GL_ARRAY_BUFFER)
+        {
+            if (target == StreamTarget::Uniform) {
+                GLint alignment;
+                glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+                mMinAlignment = std::max(alignment, 1);
+            }
+
+            // Keeps the start of every region aligned
+            mFrameCapacity = alignUp(frameCapacity, mMinAlignment);
+            auto totalSize = static_cast<GLsizeiptr>(mFrameCapacity) * FramesInFlight;
+
+            glGenBuffers(1, &mHandle);
+            glBindBuffer(mTarget, mHandle);
+
+            if (GLEW_ARB_buffer_storage) {
+                GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+                glBufferStorage(mTarget, totalSize, nullptr, flags);
+                mMapped = static_cast<std::byte*>(glMapBufferRange(mTarget, 0, totalSize, flags));
+            } else {
+                glBufferData(mTarget, totalSize, nullptr, GL_STREAM_DRAW);
+                mStaging.resize(mFrameCapacity);
+            }
+
+            glBindBuffer(mTarget, 0);
+        }
+
+        ~StreamBufferImpl() override {
+            for (auto fence : mFences) {
+                if (fence != nullptr) {
+                    glDeleteSync(fence);
+                }
+            }
+
+            if (mMapped != nullptr) {
+                glBindBuffer(mTarget, mHandle);
+                glUnmapBuffer(mTarget);
+            }
+
+            glDeleteBuffers(1, &mHandle);
+        }
+
+        void beginFrame() override {
+            mFrame = (mFrame + 1) % FramesInFlight;
+
+            auto &fence = mFences[mFrame];
+            if (fence != nullptr) {
+                while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FenceTimeout) == GL_TIMEOUT_EXPIRED) {
+                }
+
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+
+            mCursor = 0;
+            mCommitted = 0;
+        }
+
+        StreamAllocation allocate(uint32_t size, uint32_t alignment) override {
+            auto start = alignUp(mCursor, std::max(alignment, mMinAlignment));
+            if (start + size > mFrameCapacity) {
+                throw std::runtime_error("Stream buffer frame capacity exceeded");
+            }
+
+            mCursor = start + size;
+
+            auto data = mMapped != nullptr ? mMapped + regionOffset() + start : mStaging.data() + start;
+            return { data, regionOffset() + start };
+        }
+
+        void commit() override {
+            if (mMapped != nullptr || mCursor == mCommitted) {
+                return;
+            }
+
+            // The fence already guarantees the GPU is done with this region, so the map doesn't need to synchronize
+            glBindBuffer(mTarget, mHandle);
+            auto destination = glMapBufferRange(mTarget, regionOffset() + mCommitted, mCursor - mCommitted,
+                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            std::memcpy(destination, mStaging.data() + mCommitted, mCursor - mCommitted);
+            glUnmapBuffer(mTarget);
+
+            mCommitted = mCursor;
+        }
+
+        void endFrame() override {
+            mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        [[nodiscard]] uint32_t frameCapacity() const override {
+            return mFrameCapacity;
+        }
+
+        void bind() const override {
+            glBindBuffer(mTarget, mHandle);
+        }
+
+        void bindRange(uint32_t binding, uint32_t offset, uint32_t size) const override {
+            glBindBufferRange(mTarget, binding, mHandle, offset, size);
+        }
+    private:
+        static constexpr GLuint64 FenceTimeout = 1'000'000'000;
+
+        GLenum mTarget;
+        GLuint mHandle;
+        uint32_t mFrameCapacity;
+        uint32_t mMinAlignment { 1 };
+
+        std::byte *mMapped { nullptr };
+        std::vector<std::byte> mStaging;
+
+        std::array<GLsync, FramesInFlight> mFences {};
+        uint32_t mFrame { 0 };
+        uint32_t mCursor { 0 };
+        uint32_t mCommitted { 0 };
+
+        [[nodiscard]] uint32_t regionOffset() const {
+            return mFrame * mFrameCapacity;
+        }
+
+        static uint32_t alignUp(uint32_t value, uint32_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    };
+
+    std::unique_ptr<StreamBuffer> StreamBuffer::create(StreamTarget target, uint32_t frameCapacity) {
+        return std::make_unique<StreamBufferImpl>(target, frameCapacity);
+    }
+}
@@ -1,6 +1,70 @@
 #include "helpers.h"
 
+#include <cstdlib>
+#include <stdexcept>
+#include "engine/memory_tracker.h"
+#include "engine/logging.h"
+
 namespace lua {
+    // Lua's memory comes from the system heap so scripts can't exhaust the engine heap, it is only counted under
+    // MemoryTag::Lua. Lua passes the block size it asked for last as oldSize, so no header is needed.
+    static void* allocate(void *, void *pointer, size_t oldSize, size_t newSize) {
+        auto &tracker = MemoryTracker::instance();
+
+        if (newSize == 0) {
+            if (pointer) {
+                tracker.recordDeallocation(MemoryTag::Lua, pointer, oldSize);
+                std::free(pointer);
+            }
+
+            return nullptr;
+        }
+
+        // Without a block oldSize holds the type of the object being created
+        if (pointer == nullptr) {
+            auto result = std::malloc(newSize);
+            if (result) {
+                tracker.recordAllocation(MemoryTag::Lua, result, newSize);
+            }
+
+            return result;
+        }
+
+        // Shrinking keeps the block, the collector shrinks tables and strings often
+        if (newSize <= oldSize) {
+            tracker.recordDeallocation(MemoryTag::Lua, pointer, oldSize);
+            tracker.recordAllocation(MemoryTag::Lua, pointer, newSize);
+            return pointer;
+        }
+
+        // Lua raises its own memory error on a null pointer and keeps the old block
+        auto result = std::realloc(pointer, newSize);
+        if (result) {
+            tracker.recordDeallocation(MemoryTag::Lua, pointer, oldSize);
+            tracker.recordAllocation(MemoryTag::Lua, result, newSize);
+        }
+
+        return result;
+    }
+
+    static int panic(lua_State *L) {
+        auto message = lua_tostring(L, -1);
+        Logger::error("Lua panic: {}", message ? message : "unknown error");
+        return 0;
+    }
+
+    lua_State* newState() {
+        auto L = lua_newstate(allocate, nullptr);
+        if (L == nullptr) {
+            throw std::runtime_error("Failed to create lua state");
+        }
+
+        // luaL_newstate installs the same kind of handler
+        lua_atpanic(L, panic);
+
+        return L;
+    }
+
     bool execute(lua_State* L, const std::string &script, const std::string &name, int resultsCount) {
         if(luaL_loadbuffer(L, script.c_str(), script.length(), name.c_str()) != 0) {
             printf("Lua failed to load script named: %s", name.c_str());
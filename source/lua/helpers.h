@@ -10,6 +10,9 @@ extern "C" {
 }
 
 namespace lua {
+    // Creates a state whose memory is attributed to MemoryTag::Lua
+    lua_State* newState();
+
     bool execute(lua_State* L, const std::string &script, const std::string &name, int resultsCount);
 
     template<typename T>
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <limits>
+#include <glm/glm.hpp>
+#include "platform/gcc.h"
+
+namespace math {
+    // Axis aligned box, an empty box has min above max so growing it by any point or box gives that point or box
+    struct Aabb {
+        glm::vec3 min { std::numeric_limits<float>::max() };
+        glm::vec3 max { std::numeric_limits<float>::lowest() };
+
+        [[nodiscard]] ALWAYS_INLINE bool empty() const {
+            return min.x > max.x;
+        }
+
+        [[nodiscard]] ALWAYS_INLINE glm::vec3 center() const {
+            return (min + max) * 0.5f;
+        }
+
+        [[nodiscard]] ALWAYS_INLINE glm::vec3 extents() const {
+            return (max - min) * 0.5f;
+        }
+
+        [[nodiscard]] ALWAYS_INLINE Aabb translated(const glm::vec3 &offset) const {
+            return { min + offset, max + offset };
+        }
+
+        ALWAYS_INLINE void grow(const Aabb &other) {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+    };
+}
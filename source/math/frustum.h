@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <glm/glm.hpp>
+#include "aabb.h"
+#include "platform/gcc.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace math {
+    // The six clip planes of a view projection matrix, stored as four plane batches of x, y, z and distance so a box
+    // is tested against four planes per SSE instruction. The two padding planes accept everything.
+    class Frustum {
+    public:
+        Frustum() = default;
+
+        // Planes point inwards, extracted from the rows of the matrix as in Gribb and Hartmann
+        explicit Frustum(const glm::mat4 &viewProjection) {
+            auto row = [&](int i) {
+                return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+            };
+
+            const std::array<glm::vec4, 6> planes {
+                row(3) + row(0),
+                row(3) - row(0),
+                row(3) + row(1),
+                row(3) - row(1),
+                row(3) + row(2),
+                row(3) - row(2),
+            };
+
+            for (std::size_t i = 0; i < PlaneCount; i++) {
+                auto plane = i < planes.size() ? planes[i] / glm::length(glm::vec3(planes[i])) : glm::vec4(0, 0, 0, 1);
+
+                mX[i] = plane.x;
+                mY[i] = plane.y;
+                mZ[i] = plane.z;
+                mW[i] = plane.w;
+            }
+        }
+
+        // Conservative, boxes straddling a frustum corner may pass
+        [[nodiscard]] ALWAYS_INLINE bool intersects(const Aabb &box) const {
+            auto center = box.center();
+            auto extents = box.extents();
+
+#ifdef __SSE2__
+            auto cx = _mm_set1_ps(center.x);
+            auto cy = _mm_set1_ps(center.y);
+            auto cz = _mm_set1_ps(center.z);
+            auto ex = _mm_set1_ps(extents.x);
+            auto ey = _mm_set1_ps(extents.y);
+            auto ez = _mm_set1_ps(extents.z);
+            auto signMask = _mm_set1_ps(-0.0f);
+
+            for (std::size_t i = 0; i < PlaneCount; i += 4) {
+                auto x = _mm_load_ps(&mX[i]);
+                auto y = _mm_load_ps(&mY[i]);
+                auto z = _mm_load_ps(&mZ[i]);
+
+                // Signed distance of the center plus the box radius projected on the plane normal
+                auto distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, cx), _mm_mul_ps(y, cy)),
+                                           _mm_add_ps(_mm_mul_ps(z, cz), _mm_load_ps(&mW[i])));
+                auto radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, x), ex),
+                                                    _mm_mul_ps(_mm_andnot_ps(signMask, y), ey)),
+                                         _mm_mul_ps(_mm_andnot_ps(signMask, z), ez));
+
+                if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps())) != 0) {
+                    return false;
+                }
+            }
+#else
+            for (std::size_t i = 0; i < PlaneCount; i++) {
+                auto distance = mX[i] * center.x + mY[i] * center.y + mZ[i] * center.z + mW[i];
+                auto radius = std::abs(mX[i]) * extents.x + std::abs(mY[i]) * extents.y + std::abs(mZ[i]) * extents.z;
+
+                if (distance + radius < 0.0f) {
+                    return false;
+                }
+            }
+#endif
+
+            return true;
+        }
+    private:
+        static constexpr std::size_t PlaneCount = 8;
+
+        alignas(16) std::array<float, PlaneCount> mX {};
+        alignas(16) std::array<float, PlaneCount> mY {};
+        alignas(16) std::array<float, PlaneCount> mZ {};
+        alignas(16) std::array<float, PlaneCount> mW {};
+    };
+}
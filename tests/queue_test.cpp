@@ -0,0 +1,136 @@
+// Concurrency stress test of the engine queues, exits with 1 on the first failed check
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "engine/allocator.h"
+#include "engine/queue.h"
+
+static bool check(bool condition, const char *message) {
+    if (!condition) {
+        std::printf("FAILED: %s\n", message);
+    }
+
+    return condition;
+}
+
+// One producer, one consumer, every item must arrive once and in order
+static bool spscOrdering(Allocator &allocator) {
+    constexpr uint64_t Count = 2'000'000;
+    SpscQueue<uint64_t> queue { allocator, 1024 };
+
+    std::thread producer([&]() {
+        for (uint64_t i = 0; i < Count; i++) {
+            while (!queue.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    bool ordered = true;
+    for (uint64_t expected = 0; expected < Count;) {
+        if (auto value = queue.pop()) {
+            ordered &= *value == expected;
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+
+    return check(ordered, "spsc items arrive in order") && check(queue.size() == 0, "spsc queue drained");
+}
+
+// Producers push disjoint ranges, the consumers together must pop every value exactly once
+static bool mpmcChecksum(Allocator &allocator, int producerCount, int consumerCount) {
+    constexpr uint64_t PerProducer = 500'000;
+    MpmcQueue<uint64_t> queue { allocator, 1024 };
+
+    auto total = PerProducer * producerCount;
+    std::atomic<uint64_t> popped { 0 };
+    std::atomic<uint64_t> sum { 0 };
+    std::vector<std::atomic<uint8_t>> seen(total);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producerCount; p++) {
+        threads.emplace_back([&, p]() {
+            for (uint64_t i = 0; i < PerProducer; i++) {
+                while (!queue.push(p * PerProducer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (int c = 0; c < consumerCount; c++) {
+        threads.emplace_back([&]() {
+            while (popped.load(std::memory_order_relaxed) < total) {
+                if (auto value = queue.pop()) {
+                    seen[*value].fetch_add(1, std::memory_order_relaxed);
+                    sum.fetch_add(*value, std::memory_order_relaxed);
+                    popped.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    bool once = true;
+    for (auto &count : seen) {
+        once &= count.load() == 1;
+    }
+
+    return check(sum.load() == total * (total - 1) / 2, "mpmc checksum matches")
+        && check(once, "mpmc pops every value exactly once")
+        && check(!queue.pop(), "mpmc queue drained");
+}
+
+// Items left behind are destroyed with the queue, full and empty queues refuse pushes and pops
+static bool boundsAndOwnership(Allocator &allocator) {
+    bool result = true;
+
+    {
+        SpscQueue<std::string> queue { allocator, 4 };
+        for (int i = 0; i < 4; i++) {
+            result &= check(queue.push(std::string(64, 'a' + i)), "spsc accepts up to its capacity");
+        }
+
+        result &= check(!queue.push("full"), "spsc refuses a push when full");
+        result &= check(queue.pop() == std::string(64, 'a'), "spsc pops the oldest item");
+    }
+
+    {
+        MpmcQueue<std::string> queue { allocator, 3 };
+        result &= check(queue.capacity() == 4, "mpmc rounds the capacity up to a power of two");
+        result &= check(!queue.pop(), "mpmc pop on an empty queue");
+
+        for (int i = 0; i < 4; i++) {
+            result &= check(queue.push(std::string(64, 'a' + i)), "mpmc accepts up to its capacity");
+        }
+
+        result &= check(!queue.push("full"), "mpmc refuses a push when full");
+    }
+
+    return result && check(allocator.used() == 0, "queues release their slots and items");
+}
+
+int main() {
+    TlsfAllocator allocator { 1024 * 1024 };
+
+    bool passed = boundsAndOwnership(allocator);
+    passed &= spscOrdering(allocator);
+    passed &= mpmcChecksum(allocator, 1, 4);
+    passed &= mpmcChecksum(allocator, 4, 1);
+    passed &= mpmcChecksum(allocator, 4, 4);
+
+    std::printf("%s\n", passed ? "queue tests passed" : "queue tests failed");
+    return passed ? 0 : 1;
+}